@@ -0,0 +1,137 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitAsync.h"
+#include "InitException.h"
+
+#include <fstream>
+
+namespace Init {
+    class InitThreadPoolReader::PoolFile final : public File {
+        InitThreadPoolReader& pool;
+        std::string           fileName;
+        std::ifstream         stream;
+
+        friend class InitThreadPoolReader;
+
+    public:
+        PoolFile(InitThreadPoolReader& pool, std::string const& fileName) : pool(pool),
+                                                                            fileName(fileName),
+                                                                            stream(fileName, std::ios::binary) {}
+
+        void read(std::span<char> buffer, Completion done) override {
+            pool.submit([this, buffer, done = std::move(done)] {
+                std::size_t        bytes = 0;
+                std::exception_ptr error{};
+                try {
+                    stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                    if (stream.bad()) {
+                        throw InitException("Could not read " + fileName);
+                    }
+                    bytes = static_cast<std::size_t>(stream.gcount());
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                done(bytes, error);
+            });
+        }
+    };
+
+    InitAsyncReader& InitAsyncReader::shared() {
+        static InitThreadPoolReader reader{2};
+        return reader;
+    }
+
+    InitThreadPoolReader::InitThreadPoolReader(std::size_t threads) {
+        workers.reserve(threads);
+        for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); i++) {
+            workers.emplace_back([this](std::stop_token const& stop) { work(stop); });
+        }
+    }
+
+    void InitThreadPoolReader::submit(std::function<void()> job) {
+        {
+            std::lock_guard const guard{lock};
+            jobs.push_back(std::move(job));
+        }
+        queued.notify_one();
+    }
+
+    void InitThreadPoolReader::work(std::stop_token const& stop) {
+        while (true) {
+            std::unique_lock guard{lock};
+            // keeps going after a stop request until the queue is empty, so nothing waits forever
+            if (!queued.wait(guard, stop, [this] { return !jobs.empty(); })) {
+                return;
+            }
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            guard.unlock();
+            job();
+        }
+    }
+
+    void InitThreadPoolReader::open(std::string const& fileName, Completion done) {
+        submit([this, fileName, done = std::move(done)] {
+            std::unique_ptr<File> file{};
+            std::exception_ptr    error{};
+            try {
+                auto opened = std::make_unique<PoolFile>(*this, fileName);
+                if (!opened->stream.is_open()) {
+                    throw InitException("Could not open " + fileName);
+                }
+                file = std::move(opened);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            done(std::move(file), error);
+        });
+    }
+
+    namespace Async {
+        Open::Open(InitAsyncReader& reader, std::string const& fileName) noexcept : reader(reader),
+                                                                                   fileName(fileName) {}
+
+        bool Open::await_suspend(std::coroutine_handle<> handle) {
+            waiting = handle;
+            reader.open(fileName, [this](std::unique_ptr<InitAsyncReader::File> opened, std::exception_ptr failure) {
+                file  = std::move(opened);
+                error = std::move(failure);
+                // whoever gets here second carries the coroutine on
+                if (completed.exchange(true, std::memory_order_acq_rel)) {
+                    waiting.resume();
+                }
+            });
+            return !completed.exchange(true, std::memory_order_acq_rel);
+        }
+
+        std::unique_ptr<InitAsyncReader::File> Open::await_resume() {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(file);
+        }
+
+        Read::Read(InitAsyncReader::File& file, std::span<char> buffer) noexcept : file(file), buffer(buffer) {}
+
+        bool Read::await_suspend(std::coroutine_handle<> handle) {
+            waiting = handle;
+            file.read(buffer, [this](std::size_t read, std::exception_ptr failure) {
+                bytes = read;
+                error = std::move(failure);
+                if (completed.exchange(true, std::memory_order_acq_rel)) {
+                    waiting.resume();
+                }
+            });
+            return !completed.exchange(true, std::memory_order_acq_rel);
+        }
+
+        std::size_t Read::await_resume() {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return bytes;
+        }
+    } // namespace Async
+} // namespace Init
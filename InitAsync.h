@@ -0,0 +1,248 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITASYNC_H
+#define INITASYNC_H
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace Init {
+    /// Reads files in chunks without blocking the caller; what `InitFile::parseAsync` and
+    /// `InitFile::reloadAsync` read through. Each operation returns straight away and calls its
+    /// completion later, on any thread, with either a result or the exception that stopped it.
+    /// Implement this on top of an event loop's own file I/O to keep everything on that loop
+    class InitAsyncReader {
+    public:
+        /// a file opened by `open`
+        class File {
+        public:
+            using Completion = std::function<void(std::size_t bytes, std::exception_ptr error)>;
+
+            virtual ~File() = default;
+
+            /// reads the next bytes of the file into `buffer` and completes with how many were read,
+            /// which is 0 only at the end of the file. At most one read is in progress at a time
+            virtual void read(std::span<char> buffer, Completion done) = 0;
+        };
+
+        using Completion = std::function<void(std::unique_ptr<File> file, std::exception_ptr error)>;
+
+        virtual ~InitAsyncReader() = default;
+
+        virtual void open(std::string const& fileName, Completion done) = 0;
+
+        /// the reader used when none is given: an InitThreadPoolReader shared by the whole program
+        static InitAsyncReader& shared();
+    };
+
+    /// Does the blocking reads of an InitAsyncReader on threads of its own and completes on them.
+    /// Work still queued when the reader is destroyed is finished first
+    class InitThreadPoolReader final : public InitAsyncReader {
+        class PoolFile;
+
+        std::mutex                         lock;
+        std::condition_variable_any        queued;
+        std::deque<std::function<void()> > jobs;
+        std::vector<std::jthread>          workers;
+
+        void submit(std::function<void()> job);
+
+        void work(std::stop_token const& stop);
+
+    public:
+        explicit InitThreadPoolReader(std::size_t threads = 1);
+
+        void open(std::string const& fileName, Completion done) override;
+    };
+
+    namespace Async {
+        /// the awaitable operations `InitFile::parseAsync` is written with. The coroutine is resumed
+        /// on whichever thread the reader completes on, or carries straight on if it completes at once
+        class Open {
+            InitAsyncReader&                       reader;
+            std::string const&                     fileName;
+            std::unique_ptr<InitAsyncReader::File> file;
+            std::exception_ptr                     error;
+            std::atomic<bool>                      completed{false};
+            std::coroutine_handle<>                waiting;
+
+        public:
+            Open(InitAsyncReader& reader, std::string const& fileName) noexcept;
+
+            [[nodiscard]] bool await_ready() const noexcept {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle);
+
+            std::unique_ptr<InitAsyncReader::File> await_resume();
+        };
+
+        class Read {
+            InitAsyncReader::File&  file;
+            std::span<char>         buffer;
+            std::size_t             bytes{};
+            std::exception_ptr      error;
+            std::atomic<bool>       completed{false};
+            std::coroutine_handle<> waiting;
+
+        public:
+            Read(InitAsyncReader::File& file, std::span<char> buffer) noexcept;
+
+            [[nodiscard]] bool await_ready() const noexcept {
+                return false;
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle);
+
+            std::size_t await_resume();
+        };
+
+        /// where an InitTask keeps what its coroutine returned or threw
+        template <class T>
+        class Outcome {
+            std::variant<std::monostate, T, std::exception_ptr> result;
+
+        public:
+            void return_value(T value) {
+                result.template emplace<1>(std::move(value));
+            }
+
+            void unhandled_exception() noexcept {
+                result.template emplace<2>(std::current_exception());
+            }
+
+            T take() {
+                if (result.index() == 2) {
+                    std::rethrow_exception(std::get<2>(result));
+                }
+                return std::move(std::get<1>(result));
+            }
+        };
+
+        template <>
+        class Outcome<void> {
+            std::exception_ptr error;
+
+        public:
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept {
+                error = std::current_exception();
+            }
+
+            void take() const {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    } // namespace Async
+
+    /// The result of an asynchronous operation, produced by a coroutine that starts once the task is
+    /// awaited. `co_await` it from another coroutine, which is resumed with the result (or the
+    /// exception) when the operation is over, or call get() to wait for it on the current thread
+    template <class T>
+    class [[nodiscard]] InitTask {
+    public:
+        class promise_type : public Async::Outcome<T> {
+            friend class InitTask;
+
+            std::coroutine_handle<> continuation{std::noop_coroutine()};
+            std::binary_semaphore  *finished{};
+
+        public:
+            InitTask get_return_object() noexcept {
+                return InitTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() const noexcept {
+                return {};
+            }
+
+            auto final_suspend() const noexcept {
+                struct Finish {
+                    [[nodiscard]] bool await_ready() const noexcept {
+                        return false;
+                    }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                        // the frame may be gone as soon as get() is released, so nothing touches it after
+                        if (auto *const finished = handle.promise().finished; finished != nullptr) {
+                            finished->release();
+                            return std::noop_coroutine();
+                        }
+                        return handle.promise().continuation;
+                    }
+
+                    void await_resume() const noexcept {}
+                };
+                return Finish{};
+            }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        explicit InitTask(std::coroutine_handle<promise_type> handle) noexcept : handle(handle) {}
+
+    public:
+        InitTask(InitTask&& other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+        InitTask& operator=(InitTask&& other) noexcept {
+            if (this != &other) {
+                if (handle) {
+                    handle.destroy();
+                }
+                handle = std::exchange(other.handle, {});
+            }
+            return *this;
+        }
+
+        ~InitTask() {
+            if (handle) {
+                handle.destroy();
+            }
+        }
+
+        [[nodiscard]] bool await_ready() const noexcept {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume() {
+            return handle.promise().take();
+        }
+
+        /// runs the task and blocks the calling thread until it is over. For callers that are not
+        /// coroutines themselves; a task can be awaited or waited for once
+        T get() {
+            std::binary_semaphore finished{0};
+            handle.promise().finished = &finished;
+            handle.resume();
+            finished.acquire();
+            return handle.promise().take();
+        }
+    };
+} // namespace Init
+
+#endif // INITASYNC_H
@@ -4,17 +4,97 @@
 
 #include "InitEntry.h"
 
+#include <algorithm>
 #include <utility>
 
+#include "InitException.h"
+#include "InitSection.h"
+
 
 namespace Init {
     InitEntry::InitEntry() = default;
 
-    InitEntry::InitEntry(std::string  key, std::string  value) : m_key(std::move(key)), m_value(std::move(value)) {}
+    InitEntry::InitEntry(std::string  key, std::string  value) : m_key(key), m_value(std::move(value)) {}
+
+    InitEntry::InitEntry(InitName key, std::string value) : m_key(std::move(key)), m_value(std::move(value)) {}
 
     InitEntry::InitEntry(std::pair<std::string, std::string> const& p) : m_key(p.first),
                                                                          m_value(p.second) {}
 
+    InitEntry::InitEntry(InitEntry const& other) : m_key(other.m_key),
+                                                   m_value(other.m_value),
+                                                   m_parent(other.m_parent) {}
+
+    InitEntry::InitEntry(InitEntry&& other) noexcept : m_key(std::move(other.m_key)),
+                                                       m_value(std::move(other.m_value)),
+                                                       m_parent(other.m_parent) {
+        other.invalidate();
+    }
+
+    InitEntry& InitEntry::operator=(InitEntry const& other) {
+        if (this != &other) {
+            m_key    = other.m_key;
+            m_value  = other.m_value;
+            m_parent = other.m_parent;
+            invalidate();
+        }
+        return *this;
+    }
+
+    InitEntry& InitEntry::operator=(InitEntry&& other) noexcept {
+        if (this != &other) {
+            m_key    = std::move(other.m_key);
+            m_value  = std::move(other.m_value);
+            m_parent = other.m_parent;
+            invalidate();
+            other.invalidate();
+        }
+        return *this;
+    }
+
+    InitEntry::~InitEntry() {
+        unlink();
+    }
+
+    InitEntry::Interpolation& InitEntry::interpolation() const {
+        if (!m_interpolation) {
+            m_interpolation = std::make_unique<Interpolation>();
+        }
+        return *m_interpolation;
+    }
+
+    void InitEntry::invalidate() const noexcept {
+        // an entry that is already stale has no fresh dependents: they would have been
+        // invalidated at the same time it was
+        if (!m_interpolation || m_interpolation->state == Interpolation::State::STALE) {
+            return;
+        }
+        m_interpolation->state = Interpolation::State::STALE;
+        m_interpolation->value.clear();
+        for (auto const *dependent: m_interpolation->dependents) {
+            dependent->invalidate();
+        }
+    }
+
+    void InitEntry::unlink() noexcept {
+        if (!m_interpolation) {
+            return;
+        }
+        invalidate();
+        for (auto *dependency: m_interpolation->dependencies) {
+            std::erase(dependency->m_interpolation->dependents, this);
+        }
+        for (auto *dependent: m_interpolation->dependents) {
+            std::erase(dependent->m_interpolation->dependencies, this);
+        }
+        m_interpolation.reset();
+    }
+
+    void InitEntry::setValue(std::string const& value) {
+        m_value = value;
+        invalidate();
+    }
+
     InitSection *InitEntry::parent() const {
         return m_parent;
     }
@@ -23,15 +103,170 @@ namespace Init {
         return m_key;
     }
 
+    InitName const& InitEntry::name() const noexcept {
+        return m_key;
+    }
+
     [[nodiscard]] std::string const& InitEntry::value() const {
         return m_value;
     }
 
-    [[nodiscard]] std::string& InitEntry::value() {
-        return m_value;
+    [[nodiscard]] InitEntry::ValueRef InitEntry::value() {
+        return ValueRef{*this};
+    }
+
+    thread_local bool InitEntry::deferWrites = false;
+
+    InitEntry::DeferredWrites::DeferredWrites() noexcept : previous(deferWrites) {
+        deferWrites = true;
+    }
+
+    InitEntry::DeferredWrites::~DeferredWrites() {
+        deferWrites = previous;
+    }
+
+    InitEntry::ValueRef::ValueRef(InitEntry& entry) noexcept : entry(&entry) {}
+
+    InitEntry::ValueRef& InitEntry::ValueRef::operator=(ValueRef const& other) {
+        return *this = std::string{other.get()};
+    }
+
+    InitEntry::ValueRef& InitEntry::ValueRef::operator=(std::string value) {
+        if (deferWrites) {
+            entry->m_value = std::move(value);
+        } else if (entry->m_parent == nullptr) {
+            entry->setValue(value);
+        } else {
+            entry->m_parent->updateEntry(entry->m_key, value);
+        }
+        return *this;
+    }
+
+    InitEntry::ValueRef& InitEntry::ValueRef::operator+=(std::string_view more) {
+        if (deferWrites) {
+            entry->m_value.append(more);
+            return *this;
+        }
+        return *this = get() + std::string{more};
+    }
+
+    InitEntry::ValueRef::operator std::string const&() const noexcept {
+        return entry->m_value;
+    }
+
+    std::string const& InitEntry::ValueRef::get() const noexcept {
+        return entry->m_value;
+    }
+
+    std::size_t InitEntry::ValueRef::size() const noexcept {
+        return entry->m_value.size();
+    }
+
+    bool InitEntry::ValueRef::empty() const noexcept {
+        return entry->m_value.empty();
+    }
+
+    std::string const& InitEntry::interpolated() const {
+        using State = Interpolation::State;
+
+        auto& memo = interpolation();
+        switch (memo.state) {
+            case State::PLAIN:
+                return m_value;
+            case State::EXPANDED:
+                return memo.value;
+            case State::IN_PROGRESS:
+                throw InterpolationCycle("InitEntry::interpolated: reference cycle through '" + m_key.str() + "'");
+            case State::STALE:
+                break;
+        }
+
+        auto *self = const_cast<InitEntry *>(this);
+        // the references may have changed since the last expansion so start from an empty edge set
+        for (auto *dependency: memo.dependencies) {
+            std::erase(dependency->m_interpolation->dependents, self);
+        }
+        memo.dependencies.clear();
+
+        if (m_value.find("${") == std::string::npos) {
+            memo.state = State::PLAIN;
+            return m_value;
+        }
+
+        memo.state = State::IN_PROGRESS;
+        std::string result{};
+        try {
+            std::size_t i = 0;
+            while (i < m_value.size()) {
+                auto const start = m_value.find('$', i);
+                if (start == std::string::npos) {
+                    result.append(m_value, i);
+                    break;
+                }
+                result.append(m_value, i, start - i);
+                if (m_value.compare(start, 3, "$${") == 0) {
+                    result += "${";
+                    i = start + 3;
+                    continue;
+                }
+                if (m_value.compare(start, 2, "${") != 0) {
+                    result.push_back('$');
+                    i = start + 1;
+                    continue;
+                }
+                auto const end = m_value.find('}', start + 2);
+                if (end == std::string::npos) {
+                    // an unterminated reference is kept as literal text
+                    result.append(m_value, start);
+                    break;
+                }
+
+                auto const path = m_value.substr(start + 2, end - start - 2);
+                auto      *root = m_parent;
+                while (root != nullptr && root->m_parent != nullptr) {
+                    root = root->m_parent;
+                }
+                if (root == nullptr) {
+                    throw MissingEntry("InitEntry::interpolated: unresolved reference ${" + path + "}");
+                }
+                auto const components = InitSection::path_to_components(path);
+                auto [kind, ptr]      = root->canResolveHelper(std::begin(components), std::end(components));
+                if (kind != InitSection::ResolutionType::ENTRY) {
+                    throw MissingEntry("InitEntry::interpolated: unresolved reference ${" + path + "}");
+                }
+
+                auto *target = static_cast<InitEntry *>(ptr);
+                result += target->interpolated();
+                if (std::ranges::find(memo.dependencies, target) == memo.dependencies.end()) {
+                    memo.dependencies.push_back(target);
+                    target->m_interpolation->dependents.push_back(self);
+                }
+                i = end + 1;
+            }
+        } catch (...) {
+            memo.state = State::STALE;
+            throw;
+        }
+
+        memo.value = std::move(result);
+        memo.state = State::EXPANDED;
+        return memo.value;
+    }
+
+    std::vector<std::string> InitEntry::path() const {
+        auto p = m_parent == nullptr ? std::vector<std::string>{} : m_parent->path();
+        p.push_back(m_key);
+        return p;
+    }
+
+    InitSubscriptions::Id InitEntry::subscribe(InitSubscriptions::Callback callback) const {
+        if (m_parent == nullptr) {
+            throw InitException("InitEntry::subscribe: entry does not belong to a section");
+        }
+        return m_parent->subscribe(std::vector{m_key.str()}, std::move(callback));
     }
 
     std::string InitEntry::toString() const {
-        return m_key + "=" + m_value;
+        return m_key.str() + "=" + m_value;
     }
 } // namespace Init
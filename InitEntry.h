@@ -4,41 +4,163 @@
 
 #ifndef INITENTRY_H
 #define INITENTRY_H
+#include <cstdint>
+#include <memory>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "InitName.h"
+#include "InitSubscriptions.h"
 
 namespace Init {
     class InitSection;
 
     class InitEntry {
         friend class InitSection;
+        friend class InitTransaction;
+
+        /// memoized result of expanding `${path}` references in the value along with the edges of the
+        /// dependency graph between entries. Only allocated once an entry is interpolated or referenced
+        struct Interpolation {
+            enum class State : std::uint8_t { STALE, PLAIN, EXPANDED, IN_PROGRESS };
 
-        std::string m_key;
+            State                    state{State::STALE};
+            std::string              value;
+            std::vector<InitEntry *> dependencies;
+            std::vector<InitEntry *> dependents;
+        };
+
+        InitName    m_key;
         std::string m_value;
 
         InitSection *m_parent{};
 
+        mutable std::unique_ptr<Interpolation> m_interpolation;
+
+        Interpolation& interpolation() const;
+
+        /// drops the memoized expansion of this entry and of every entry that depends on it
+        void invalidate() const noexcept;
+
+        /// removes this entry from the dependency graph, invalidating everything that depends on it
+        void unlink() noexcept;
+
+        void setValue(std::string const& value);
+
+        /// set on a thread for as long as a DeferredWrites lives on it
+        static thread_local bool deferWrites;
+
+        /// while one exists, writes through `value()` on this thread change only the text and leave
+        /// the bookkeeping to whoever created it, as parallel_visit does once its calls are done
+        struct DeferredWrites {
+            bool previous;
+
+            DeferredWrites() noexcept;
+
+            ~DeferredWrites();
+
+            DeferredWrites(DeferredWrites const&) = delete;
+
+            DeferredWrites& operator=(DeferredWrites const&) = delete;
+        };
+
     public:
+        /// what the non-const `value()` returns. It reads like the value, and a write through it goes
+        /// through `InitSection::updateEntry` on the section holding the entry, so sizes,
+        /// generations, lookup caches, references and subscribers all see the change. It refers to
+        /// the entry rather than holding a copy: use `std::string` rather than `auto` to keep one
+        class ValueRef {
+            InitEntry *entry;
+
+        public:
+            explicit ValueRef(InitEntry& entry) noexcept;
+
+            ValueRef(ValueRef const& other) = default;
+
+            /// assigns the value of `other`, not the entry it refers to
+            ValueRef& operator=(ValueRef const& other);
+
+            ValueRef& operator=(std::string value);
+
+            ValueRef& operator+=(std::string_view more);
+
+            // NOLINTNEXTLINE(google-explicit-constructor)
+            operator std::string const&() const noexcept;
+
+            [[nodiscard]] std::string const& get() const noexcept;
+
+            [[nodiscard]] std::size_t size() const noexcept;
+
+            [[nodiscard]] bool empty() const noexcept;
+
+            friend bool operator==(ValueRef const& a, std::string_view b) noexcept {
+                return a.get() == b;
+            }
+
+            friend std::string operator+(ValueRef const& a, std::string_view b) {
+                return a.get() + std::string{b};
+            }
+
+            friend std::string operator+(std::string_view a, ValueRef const& b) {
+                return std::string{a} + b.get();
+            }
+
+            friend std::ostream& operator<<(std::ostream& os, ValueRef const& v) {
+                return os << v.get();
+            }
+        };
+
         InitEntry();
 
         InitEntry(std::string key, std::string value);
 
+        InitEntry(InitName key, std::string value);
+
         InitEntry(std::pair<std::string, std::string> const& p);
 
-        InitEntry(InitEntry const& other) = default;
+        /// copies and moves carry the key, value and parent only; memoized interpolation state
+        /// belongs to the entry that sits in the tree
+        InitEntry(InitEntry const& other);
+
+        InitEntry(InitEntry&& other) noexcept;
 
-        InitEntry(InitEntry&& other) = default;
+        InitEntry& operator=(InitEntry const& other);
 
-        InitEntry& operator=(InitEntry const& other) = default;
+        InitEntry& operator=(InitEntry&& other) noexcept;
 
-        InitEntry& operator=(InitEntry&& other) = default;
+        ~InitEntry();
 
         [[nodiscard]] InitSection *parent() const;
 
         [[nodiscard]] std::string const& key() const;
 
+        /// the key as the handle stored in the section, for comparing or hashing it without reading the text
+        [[nodiscard]] InitName const& name() const noexcept;
+
         [[nodiscard]] std::string const& value() const;
 
-        [[nodiscard]] std::string& value();
+        /// the value, for reading or for changing through the section the entry belongs to. An entry
+        /// that is not in a section just takes the new value
+        [[nodiscard]] ValueRef value();
+
+        /// returns the value with every `${path}` reference replaced by the interpolated value of
+        /// the entry at `path`, resolved from the root section. `$${` produces a literal `${`.
+        /// The expansion is computed once and memoized until this entry or any entry it references
+        /// is changed through `InitSection::updateEntry` / `updateEntryExact` or replaced or removed.
+        /// Throws MissingEntry if a reference does not resolve and InterpolationCycle if the
+        /// references loop back to this entry, which `InitFile::parse` and the InitSection mutators
+        /// already check for new values
+        [[nodiscard]] std::string const& interpolated() const;
+
+        /// the names of the sections leading from the root to this entry followed by its key
+        [[nodiscard]] std::vector<std::string> path() const;
+
+        /// calls `callback` whenever this entry is updated, replaced or removed. The subscription is
+        /// made on the entry's path so it also covers an entry added later under the same key.
+        /// Throws InitException if the entry is not part of a section
+        InitSubscriptions::Id subscribe(InitSubscriptions::Callback callback) const;
 
         [[nodiscard]] std::string toString() const;
     };
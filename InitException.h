@@ -31,6 +31,10 @@ namespace Init {
         using InitException::InitException;
     };
 
+    class InterpolationCycle : public InitException {
+        using InitException::InitException;
+    };
+
     class KeySyntaxError : public ParseException {
         using ParseException::ParseException;
     };
@@ -4,83 +4,63 @@
 
 #include "InitFile.h"
 #include "InitException.h"
+#include "InitParser.h"
+#include "InitStats.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <algorithm>
+#include <stdexcept>
 
 namespace Init {
     namespace Util {
-        static int gulp_whitespace(std::ifstream& file) {
-            int c{};
-            while (!file.eof() && (c = file.get()) != EOF && (c == ' ' || c == '\t')) {}
-            return c;
-        }
-
-        static void gulp_close_brackets(std::ifstream& file) {
-            int c{};
-            while (!file.eof() && (c = file.get()) != EOF && c == ']') {}
-            file.unget();
+        static ParseDiagnostic diagnose(
+            ParseDiagnostic::Kind kind,
+            std::string_view      line,
+            std::size_t           at,
+            std::string           message
+        ) {
+            return {kind, 0, std::min(at, line.size()) + 1, std::move(message)};
         }
 
-        static void gulp_to_char(std::ifstream& file, char stop) {
-            int c;
-            while (!file.eof() && (c = file.get()) != EOF && c != stop);
-        }
-
-        static int consume_escape(std::ifstream& file) {
-            int const d = file.get();
-            if (!InitFile::is_escape_char(d)) {
-                throw ParseException("Invalid escape character");
+        static InitEntry const& resolved_entry(InitLookupCache::Resolution const& resolution) {
+            switch (resolution.first) {
+                case InitSection::ResolutionType::NONE:
+                    throw MissingEntry("InitFile::getEntryExact: no such entry");
+                case InitSection::ResolutionType::SECTION:
+                    throw InitException("InitFile::getEntryExact: can't get section ");
+                case InitSection::ResolutionType::ENTRY:
+                    return *static_cast<InitEntry const *>(resolution.second);
+                default:
+                    throw std::runtime_error("InitFile::getEntryExact: unknown branch");
             }
-            return d;
-        }
-
-
-        static std::string consume_key(std::ifstream& s, int& c) {
-            std::string k;
-            while (c != '=' && c != EOF) {
-                k.push_back(c);
-                c = s.get();
-                if (c == '\\') {
-                    c = consume_escape(s);
-                    // add the escaped char to the data
-                    k.push_back(c);
-                    // retrieve the next one
-                    c = s.get();
-                    // continue so it is pushed back
-                    continue;
-                }
-
-                if (c == '\n' || c == ';') {
-                    throw KeySyntaxError("Key ended with no corresponding value");
-                }
-            }
-            return k;
         }
 
-        static std::string consume_value(std::ifstream& s, int& c) {
-            std::string v;
-            while (c != '\n' && c != EOF && c != ';') {
-                v.push_back(c);
-                c = s.get();
-                if (c == '\\') {
-                    c = consume_escape(s);
+        /// appends the text of `line` from `i` up to the first unescaped character in `stops` to `out`.
+        /// Returns the position of that character, `line.size()` if there is none, or std::nullopt after
+        /// setting `i` to the backslash of an invalid escape
+        static std::optional<std::size_t> consume_escaped(
+            std::string_view line,
+            std::size_t&     i,
+            char const      *stops,
+            std::string&     out
+        ) {
+            std::string_view const special{stops};
+            while (i < line.size()) {
+                auto const next = line.find_first_of(special, i);
+                auto const stop = next == std::string_view::npos ? line.size() : next;
+                out.append(line.substr(i, stop - i));
+                i = stop;
+                if (i == line.size() || line[i] != '\\') {
+                    return i;
                 }
-            }
-            return v;
-        }
-
-        static std::string consume_section_name(std::ifstream& s, int& c) {
-            std::string n;
-            while (c != ']' && c != EOF) {
-                n.push_back(c);
-                c = s.get();
-                if (c == '\n' || c == ';') {
-                    throw SectionSyntaxError("section name with unterminated square brackets");
+                if (i + 1 == line.size() || !InitFile::is_escape_char(line[i + 1])) {
+                    return std::nullopt;
                 }
+                out.push_back(line[i + 1]);
+                i += 2;
             }
-            return n;
+            return i;
         }
     } // namespace Util
 
@@ -97,6 +77,23 @@ namespace Init {
         // return false;
     }
 
+    void InitFile::raise(ParseDiagnostic const& diagnostic) {
+        switch (diagnostic.kind) {
+            case ParseDiagnostic::Kind::INVALID_SUBSECTION:
+                throw InvalidSubsection(diagnostic.message);
+            case ParseDiagnostic::Kind::SECTION_SYNTAX:
+                throw SectionSyntaxError(diagnostic.message);
+            case ParseDiagnostic::Kind::KEY_SYNTAX:
+                throw KeySyntaxError(diagnostic.message);
+            case ParseDiagnostic::Kind::INTERPOLATION_CYCLE:
+                throw InterpolationCycle(diagnostic.message);
+            case ParseDiagnostic::Kind::MISSING_REFERENCE:
+                throw MissingEntry(diagnostic.message);
+            default:
+                throw ParseException(diagnostic.message);
+        }
+    }
+
     void InitFile::pop_section(std::vector<InitSection *>& secstack) {
         secstack.pop_back();
     }
@@ -109,10 +106,83 @@ namespace Init {
         return defaultSection;
     }
 
+    void InitFile::enableLookupCache(std::size_t capacity) {
+        if (capacity == 0) {
+            disableLookupCache();
+            return;
+        }
+        lookupCache.emplace(capacity);
+    }
+
+    void InitFile::disableLookupCache() noexcept {
+        lookupCache.reset();
+    }
+
+    InitLookupCache::Statistics InitFile::lookupCacheStats() const noexcept {
+        return lookupCache.has_value() ? lookupCache->stats() : InitLookupCache::Statistics{};
+    }
+
+    // lookups answered by the cache are timed here so that they count the same as uncached ones
+
+    InitSection::ResolutionType InitFile::canResolve(std::string const& path) const {
+        if (!lookupCache.has_value()) {
+            return defaultSection.canResolve(path);
+        }
+        Stats::LookupTimer timer{Stats::Api::CAN_RESOLVE};
+        auto const         kind = lookupCache->resolve(defaultSection, path).first;
+        if (kind != InitSection::ResolutionType::NONE) {
+            timer.hit();
+        }
+        return kind;
+    }
+
+    InitSection::ResolutionType InitFile::canResolve(std::vector<std::string> const& path) const {
+        if (!lookupCache.has_value()) {
+            return defaultSection.canResolve(path);
+        }
+        Stats::LookupTimer timer{Stats::Api::CAN_RESOLVE};
+        auto const         kind = lookupCache->resolve(defaultSection, path).first;
+        if (kind != InitSection::ResolutionType::NONE) {
+            timer.hit();
+        }
+        return kind;
+    }
+
+    InitEntry const& InitFile::getEntryExact(std::string const& path) const {
+        if (!lookupCache.has_value()) {
+            return defaultSection.getEntryExact(path);
+        }
+        Stats::LookupTimer timer{Stats::Api::GET_ENTRY_EXACT};
+        auto const&        entry = Util::resolved_entry(lookupCache->resolve(defaultSection, path));
+        timer.hit();
+        return entry;
+    }
+
+    InitEntry const& InitFile::getEntryExact(std::vector<std::string> const& path) const {
+        if (!lookupCache.has_value()) {
+            return defaultSection.getEntryExact(path);
+        }
+        Stats::LookupTimer timer{Stats::Api::GET_ENTRY_EXACT};
+        auto const&        entry = Util::resolved_entry(lookupCache->resolve(defaultSection, path));
+        timer.hit();
+        return entry;
+    }
+
+    std::optional<std::vector<std::string> > InitFile::getPathToEntry(std::string const& key) const {
+        if (!lookupCache.has_value()) {
+            return defaultSection.getPathToEntry(key);
+        }
+        Stats::LookupTimer timer{Stats::Api::GET_PATH_TO_ENTRY};
+        auto               path = lookupCache->locate(defaultSection, key);
+        if (path.has_value()) {
+            timer.hit();
+        }
+        return path;
+    }
+
     std::string InitFile::escaped(std::string const& key) {
         std::string result{};
         for (char const i: key) {
-            std::cout << "Key: " << key << " key[i]: " << i << std::endl;
             if (is_escape_char(i)) {
                 result.push_back('\\');
             }
@@ -121,6 +191,127 @@ namespace Init {
         return result;
     }
 
+    std::optional<ParseDiagnostic> InitFile::parse_line(
+        std::string_view            line,
+        std::vector<InitSection *>& secstack,
+        int&                        subsectionLevel
+    ) {
+        // allows us to use whitespace for nesting in the init file.
+        // ignore line initial whitespace
+        auto i = line.find_first_not_of(" \t");
+
+        // skip blank lines and comments
+        if (i == std::string_view::npos || line[i] == ';') {
+            return std::nullopt;
+        }
+
+        // deal with section headers (start/end)
+        if (line[i] == '[') {
+            // determine the depth of the subsection that is about to be read
+            int prox = 0;
+            for (; i < line.size() && line[i] == '['; i++) {
+                prox += 1;
+                if (prox > (subsectionLevel + 1)) {
+                    return Util::diagnose(
+                        ParseDiagnostic::Kind::INVALID_SUBSECTION,
+                        line,
+                        i,
+                        "Subsection level too deeply nested. Missing parent subsection"
+                    );
+                }
+            }
+            // after the [
+            if (i < line.size() && line[i] == '~') {
+                // ~ simply ends the section concordant with the subsection level indicated by the brackets
+                // pop while prox <= subsection level. The rest of the line is ignored
+                while (prox <= subsectionLevel) {
+                    pop_section(secstack);
+                    subsectionLevel--;
+                }
+                return std::nullopt;
+            }
+
+            // read the section name
+            auto const close = line.find_first_of("];", i);
+            if (close == std::string_view::npos || line[close] == ';') {
+                return Util::diagnose(
+                    ParseDiagnostic::Kind::SECTION_SYNTAX,
+                    line,
+                    close,
+                    "section name with unterminated square brackets"
+                );
+            }
+            std::string name{line.substr(i, close - i)};
+
+            // discard closing brackets and whitespace. Only a comment may follow
+            auto const rest = line.find_first_not_of("] \t", close);
+            if (rest != std::string_view::npos && line[rest] != ';') {
+                return Util::diagnose(
+                    ParseDiagnostic::Kind::SECTION_SYNTAX,
+                    line,
+                    rest,
+                    "Extraneous text after section name. Keys must be on a new line"
+                );
+            }
+
+            /*
+             CASE 1: new section is the same level as the current section meaning that that current section is
+             closed and the new section is opened: this requires 1 pop if prox == subsectionLevel then pushing
+             the new section
+
+             CASE 2: new section is a higher level (closer to 0, aka default section) than the current
+             section closing the current section and all sections which are lower than the impending
+             new section. This requires several pops until the levels work out. Then it requires 1 push
+             to open the new section
+
+             CASE 3: new section is a lower level than the current section opening a new subsection of the
+             current section; creating a deeper subsection requires only pushing with no popping if prox > subsectionLevel
+             @brief: pop 1 time for equal section, many times for higher section, none for lower section
+             */
+            while (prox <= subsectionLevel) {
+                pop_section(secstack);
+                subsectionLevel--;
+            }
+
+            // push the new section after appropriate closing of existing sections
+            Stats::PhaseTimer build{Stats::Phase::BUILD};
+            Stats::ParseRecorder::section(prox);
+            secstack.push_back(&secstack.back()->createSubsection(name));
+            subsectionLevel = prox;
+            return std::nullopt;
+        }
+
+        // if the line is not whitespace, a comment, or a section header, it must be a key value pair
+        // read key
+        std::string k{};
+        auto const  equals = Util::consume_escaped(line, i, "=;\\", k);
+        if (!equals.has_value()) {
+            return Util::diagnose(ParseDiagnostic::Kind::INVALID_ESCAPE, line, i, "Invalid escape character");
+        }
+        if (*equals == line.size() || line[*equals] == ';') {
+            return Util::diagnose(
+                ParseDiagnostic::Kind::KEY_SYNTAX,
+                line,
+                *equals,
+                "Key ended with no corresponding value"
+            );
+        }
+
+        // discard = and read the value, which ends at a comment
+        i++;
+        std::string v{};
+        if (!Util::consume_escaped(line, i, ";\\", v).has_value()) {
+            return Util::diagnose(ParseDiagnostic::Kind::INVALID_ESCAPE, line, i, "Invalid escape character");
+        }
+
+        // add the key value pair to the current section
+        Stats::PhaseTimer build{Stats::Phase::BUILD};
+        Stats::ParseRecorder::entry();
+        auto *const section = secstack.back();
+        section->insertEntry(InitEntry{section->intern(k), std::move(v)});
+        return std::nullopt;
+    }
+
     InitFile InitFile::parse(std::string const& fileName) {
         InitFile file{};
 
@@ -132,123 +323,147 @@ namespace Init {
         std::vector<InitSection *> secstack{};
         secstack.push_back(&file.defaultSection);
 
-
-        while (s.good() && !s.eof()) {
-            int c = s.get();
-
-            // eof check if there are blank lines
-            if (c == EOF) {
-                continue;
+        Stats::ParseRecorder recorder{};
+        std::string          line{};
+        auto const           next_line = [&s, &line] {
+            Stats::PhaseTimer read{Stats::Phase::READ};
+            return static_cast<bool>(std::getline(s, line));
+        };
+
+        // positions are only worked out once a line turns out to be invalid
+        while (next_line()) {
+            recorder.line(line.size() + 1);
+            std::optional<ParseDiagnostic> diagnostic{};
+            {
+                Stats::PhaseTimer tokenize{Stats::Phase::TOKENIZE};
+                diagnostic = parse_line(line, secstack, subsectionLevel);
             }
-
-            // allows us to use whitespace for nesting in the init file.
-            // ignore line initial whitespace
-            while (c == '\t' || c == ' ') {
-                c = s.get();
+            if (diagnostic.has_value()) {
+                recorder.finish(false);
+                raise(*diagnostic);
             }
+        }
 
-            // skip comments
-            if (c == ';') {
-                // skip comments
-                Util::gulp_to_char(s, '\n');
-                continue;
-            }
+        try {
+            file.defaultSection.verifyInterpolation();
+        } catch (...) {
+            recorder.finish(false);
+            throw;
+        }
+        recorder.finish(true);
+        return file;
+    }
 
-            // skip blank lines
-            if (c == '\n') {
+    void InitFile::check_references(InitSection const& section, std::vector<ParseDiagnostic>& diagnostics) {
+        for (auto const& [key, entry]: section.entries) {
+            if (entry.value().find("${") == std::string::npos) {
                 continue;
             }
-
-            // deal with section headers (start/end)
-            if (c == '[') {
-                // determine the depth of the subsection that is about to be read
-                int prox = 0;
-                while (s.good() && !s.eof() && c == '[') {
-                    prox += 1;
-                    c = s.get();
-                    if (prox > (subsectionLevel + 1)) {
-                        throw InvalidSubsection("Subsection level too deeply nested. Missing parent subsection");
-                    }
+            auto const report = [&diagnostics, &entry](ParseDiagnostic::Kind kind, InitException const& e) {
+                std::string where{};
+                for (auto const& component: entry.path()) {
+                    where += (where.empty() ? "" : "/") + component;
                 }
-                // after the [
-                if (c == '~') {
-                    // ~ simply ends the section concordant with the subsection level indicated by the brackets
-                    // pop while prox <= subsection level
-                    while (prox <= subsectionLevel) {
-                        pop_section(secstack);
-                        subsectionLevel--;
-                    }
-                    // discard closing brackets
-                    Util::gulp_to_char(s, '\n');
-                } else {
-                    // read the section name
-                    std::string name = Util::consume_section_name(s, c);
-                    // discard closing brackets
-                    Util::gulp_close_brackets(s);
-
-                    int d = Util::gulp_whitespace(s);
-
-                    // if the line doesn't end or have a comment there is extra text
-                    if (d != ';' && d != '\n') {
-                        throw SectionSyntaxError("Extraneous text after section name. Keys must be on a new line");
-                    }
-
-                    // if after whitespace is a newline, we are on the first key in the section
-                    // without the d == ';' check we eat the first key in each section
-                    if (d == ';') {
-                        Util::gulp_to_char(s, '\n');
-                    }
-
-                    /*
-                     CASE 1: new section is the same level as the current section meaning that that current section is
-                     closed and the new section is opened: this requires 1 pop if prox == subsectionLevel then pushing
-                     the new section
-
-                     CASE 2: new section is a higher level (closer to 0, aka default section) than the current
-                     section closing the current section and all sections which are lower than the impending
-                     new section. This requires several pops until the levels work out. Then it requires 1 push
-                     to open the new section
-
-                     CASE 3: new section is a lower level than the current section opening a new subsection of the
-                     current section; creating a deeper subsection requires only pushing with no popping if prox > subsectionLevel
-                     @brief: pop 1 time for equal section, many times for higher section, none for lower section
-                     */
-                    while (prox <= subsectionLevel) {
-                        pop_section(secstack);
-                        subsectionLevel--;
-                    }
-
-                    // push the new section after appropriate closing of existing sections
-                    secstack.back()->subsections[name] = InitSection(name);
-                    secstack.push_back(&secstack.back()->subsections[name]);
-                    subsectionLevel = prox;
-                }
-                // section opener or closer is read so continue
-                continue;
+                diagnostics.push_back({kind, 0, 0, where + ": " + e.what()});
+            };
+            try {
+                (void) entry.interpolated();
+            } catch (InterpolationCycle const& e) {
+                report(ParseDiagnostic::Kind::INTERPOLATION_CYCLE, e);
+            } catch (MissingEntry const& e) {
+                report(ParseDiagnostic::Kind::MISSING_REFERENCE, e);
             }
+        }
+        for (auto const& [name, subsection]: section.subsections) {
+            check_references(subsection, diagnostics);
+        }
+    }
 
-            // if the current character is not whitespace, comments, or section headers, it must be a key value pair
-            // read key
-            std::string k = Util::consume_key(s, c);
+    InitFile::ParseResult InitFile::tryParse(std::string const& fileName) {
+        InitFile file{};
 
-            // discard =
-            c = s.get();
+        std::ifstream s;
+        s.open(fileName);
+        if (!s.is_open()) {
+            return std::unexpected(std::vector{
+                ParseDiagnostic{ParseDiagnostic::Kind::UNREADABLE, 0, 0, "Could not open " + fileName}
+            });
+        }
 
-            // read the value
-            std::string v = Util::consume_value(s, c);
+        int                          subsectionLevel = 0;
+        std::vector<InitSection *>   secstack{};
+        std::vector<ParseDiagnostic> diagnostics{};
+        secstack.push_back(&file.defaultSection);
 
-            // eat the rest of the line in case there's a comment
-            if (c != '\n') {
-                Util::gulp_to_char(s, '\n');
+        Stats::ParseRecorder recorder{};
+        std::string          line{};
+        auto const           next_line = [&s, &line] {
+            Stats::PhaseTimer read{Stats::Phase::READ};
+            return static_cast<bool>(std::getline(s, line));
+        };
+
+        for (std::size_t number = 1; next_line(); number++) {
+            recorder.line(line.size() + 1);
+            Stats::PhaseTimer tokenize{Stats::Phase::TOKENIZE};
+            // an invalid line changes nothing, so parsing recovers by simply moving on to the next line
+            if (auto diagnostic = parse_line(line, secstack, subsectionLevel); diagnostic.has_value()) {
+                diagnostic->line = number;
+                diagnostics.push_back(std::move(*diagnostic));
             }
-
-            // add the key value pair to the current section
-            secstack.back()->addEntry(InitEntry{k, v});
         }
 
+        // with lines missing, references to what they held would be reported as well
+        if (diagnostics.empty()) {
+            check_references(file.defaultSection, diagnostics);
+        }
+        recorder.finish(diagnostics.empty());
+        if (!diagnostics.empty()) {
+            return std::unexpected(std::move(diagnostics));
+        }
         return file;
     }
 
+    InitTask<InitFile> InitFile::parseAsync(std::string fileName, InitAsyncReader& reader) {
+        auto const stream = co_await Async::Open{reader, fileName};
+
+        InitParser        parser{};
+        std::vector<char> buffer(ASYNC_CHUNK_SIZE);
+        while (auto const bytes = co_await Async::Read{*stream, buffer}) {
+            parser.feed({buffer.data(), bytes});
+        }
+        co_return parser.finish();
+    }
+
+    void InitFile::mergeFrom(InitFile const& fresh) {
+        auto *const subscriptions = defaultSection.m_subscriptions.get();
+        if (subscriptions != nullptr) {
+            subscriptions->beginBatch();
+        }
+        try {
+            defaultSection.mergeFrom(fresh.defaultSection);
+        } catch (...) {
+            if (subscriptions != nullptr) {
+                subscriptions->abandonBatch();
+            }
+            throw;
+        }
+        if (subscriptions != nullptr) {
+            subscriptions->endBatch();
+        }
+        // names of entries and sections that went away are only held by the pool now
+        if (defaultSection.m_names) {
+            defaultSection.m_names->prune();
+        }
+    }
+
+    void InitFile::reload(std::string const& fileName) {
+        mergeFrom(parse(fileName));
+    }
+
+    InitTask<void> InitFile::reloadAsync(std::string fileName, InitAsyncReader& reader) {
+        mergeFrom(co_await parseAsync(std::move(fileName), reader));
+    }
+
     void InitFile::print(std::ostream& os) const {
         for (auto const& [name, entry]: defaultSection.entries) {
             os << escaped(entry.key()) << "=" << escaped(entry.value()) << std::endl;
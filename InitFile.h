@@ -4,27 +4,134 @@
 
 #ifndef INITFILE_H
 #define INITFILE_H
+#include <cstddef>
+#include <expected>
 #include <iostream>
+#include <optional>
+#include <string_view>
 
+#include "InitAsync.h"
+#include "InitLookupCache.h"
 #include "InitSection.h"
 
 namespace Init {
+    /// one problem found by `InitFile::tryParse`. `line` and `column` are 1-based and point at the
+    /// character that made the line invalid, or are 0 for a problem that is not on one line, such as
+    /// a reference cycle; `kind` tells which exception `parse` throws for it
+    struct ParseDiagnostic {
+        enum class Kind {
+            /// the file could not be opened
+            UNREADABLE,
+            /// InvalidSubsection
+            INVALID_SUBSECTION,
+            /// SectionSyntaxError
+            SECTION_SYNTAX,
+            /// KeySyntaxError
+            KEY_SYNTAX,
+            /// ParseException
+            INVALID_ESCAPE,
+            /// InterpolationCycle, reported once every line has been read
+            INTERPOLATION_CYCLE,
+            /// MissingEntry, for a `${path}` reference that does not resolve
+            MISSING_REFERENCE,
+        };
+
+        Kind        kind;
+        std::size_t line;
+        std::size_t column;
+        std::string message;
+    };
+
     class InitFile {
-        InitSection defaultSection{InitSection::DEFAULT_NAME};
+        InitSection                            defaultSection{InitSection::DEFAULT_NAME};
+        mutable std::optional<InitLookupCache> lookupCache;
+
+        friend class InitParser;
 
         static void pop_section(std::vector<InitSection *>& secstack);
 
+        /// throws the exception `parse` reports `diagnostic` with
+        [[noreturn]] static void raise(ParseDiagnostic const& diagnostic);
+
+        /// parses one line (without its newline) into the section on top of `secstack`. Returns a
+        /// diagnostic with no line number if the line is invalid, in which case nothing is changed
+        static std::optional<ParseDiagnostic> parse_line(
+            std::string_view            line,
+            std::vector<InitSection *>& secstack,
+            int&                        subsectionLevel
+        );
+
+        /// adds a diagnostic for every entry beneath `section` whose references loop or do not resolve
+        static void check_references(InitSection const& section, std::vector<ParseDiagnostic>& diagnostics);
+
+        /// brings this file in line with `fresh`, as described for `reload`
+        void mergeFrom(InitFile const& fresh);
+
     public:
         static bool is_escape_char(char c);
 
         static std::vector<char> const ESCAPE_CHARS;
 
+        using ParseResult = std::expected<InitFile, std::vector<ParseDiagnostic> >;
+
+        /// parses `fileName` and then expands every value that has references in it, so that a file
+        /// that parses is known to expand. Throws InterpolationCycle or MissingEntry for the first
+        /// reference that loops or does not resolve
         static InitFile parse(std::string const& fileName);
 
+        /// parses `fileName` without throwing. Instead of stopping at the first invalid line, every
+        /// invalid line is reported and skipped and parsing carries on with the next one; the result
+        /// holds all of the diagnostics in the order they occur if there were any. If every line is
+        /// valid, references that loop or do not resolve are reported after them, one per entry.
+        /// Unlike `parse`, a file that cannot be opened is reported rather than read as empty
+        static ParseResult tryParse(std::string const& fileName);
+
+        /// parses `fileName` and changes this file to match it. Unlike assigning the result of
+        /// `parse`, which tells subscribers nothing, only the entries and sections that differ are
+        /// touched: everything else keeps its identity and subscribers are told about all of the
+        /// differences in a single call. If parsing fails this file is left unchanged
+        void reload(std::string const& fileName);
+
+        /// how much of the file `parseAsync` asks its reader for at a time
+        constexpr static std::size_t ASYNC_CHUNK_SIZE = 64 * 1024;
+
+        /// parses `fileName` like `parse` but reads it a chunk at a time through `reader`, so the
+        /// calling thread never waits on the file. Each chunk is parsed as soon as it arrives, on the
+        /// thread the reader completes on. Unlike `parse`, a file that cannot be opened is an error
+        static InitTask<InitFile> parseAsync(
+            std::string      fileName,
+            InitAsyncReader& reader = InitAsyncReader::shared()
+        );
+
+        /// `reload` on top of `parseAsync`. This file must outlive the task and should not be used
+        /// by anything else until it is over
+        InitTask<void> reloadAsync(std::string fileName, InitAsyncReader& reader = InitAsyncReader::shared());
+
         InitSection& sections() noexcept;
 
         [[nodiscard]] InitSection const& sections() const noexcept;
 
+        /// remembers the results of the lookups below for up to `capacity` paths and keys, so that
+        /// repeating a lookup costs a single hash probe. Any change to the tree empties the cache.
+        /// A capacity of 0 turns the cache off. Lookups through the cache are not thread safe
+        void enableLookupCache(std::size_t capacity);
+
+        void disableLookupCache() noexcept;
+
+        /// all zeros if the cache is not enabled
+        [[nodiscard]] InitLookupCache::Statistics lookupCacheStats() const noexcept;
+
+        /// same as the InitSection lookups on `sections()`, but answered from the lookup cache if enabled
+        [[nodiscard]] InitSection::ResolutionType canResolve(std::string const& path) const;
+
+        [[nodiscard]] InitSection::ResolutionType canResolve(std::vector<std::string> const& path) const;
+
+        [[nodiscard]] InitEntry const& getEntryExact(std::string const& path) const;
+
+        [[nodiscard]] InitEntry const& getEntryExact(std::vector<std::string> const& path) const;
+
+        [[nodiscard]] std::optional<std::vector<std::string> > getPathToEntry(std::string const& key) const;
+
         static std::string escaped(std::string const& key);
 
         void print(std::ostream& os = std::cout) const;
@@ -0,0 +1,131 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitLookupCache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace Init {
+    double InitLookupCache::Statistics::hitRate() const noexcept {
+        auto const lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+
+    std::size_t InitLookupCache::Hash::operator()(std::string_view key) const noexcept {
+        return std::hash<std::string_view>{}(key);
+    }
+
+    InitLookupCache::InitLookupCache(std::size_t capacity) : capacity(std::max(capacity, 1uz)) {}
+
+    InitLookupCache::InitLookupCache(InitLookupCache const& other) : capacity(other.capacity) {}
+
+    InitLookupCache& InitLookupCache::operator=(InitLookupCache const& other) {
+        if (this != &other) {
+            capacity = other.capacity;
+            clear();
+        }
+        return *this;
+    }
+
+    InitLookupCache::Slot& InitLookupCache::slot(InitSection const& root, std::string_view key) {
+        if (owner != &root || generation != root.generation()) {
+            if (!slots.empty()) {
+                statistics.invalidations++;
+            }
+            clear();
+            owner      = &root;
+            generation = root.generation();
+        }
+
+        if (auto const found = index.find(key); found != index.end()) {
+            slots.splice(slots.begin(), slots, found->second);
+            return *found->second;
+        }
+
+        if (slots.size() >= capacity) {
+            index.erase(slots.back().key);
+            slots.pop_back();
+            statistics.evictions++;
+        }
+        auto& added = slots.emplace_front(Slot{std::string{key}, std::nullopt, std::nullopt});
+        index.emplace(added.key, slots.begin());
+        return added;
+    }
+
+    InitLookupCache::Resolution InitLookupCache::resolve(
+        InitSection const&              root,
+        std::string_view                key,
+        std::vector<std::string> const& path
+    ) {
+        auto& s = slot(root, key);
+        if (!s.resolution.has_value()) {
+            statistics.misses++;
+            s.resolution = const_cast<InitSection&>(root).canResolveHelper(std::begin(path), std::end(path));
+        } else {
+            statistics.hits++;
+        }
+        return *s.resolution;
+    }
+
+    InitLookupCache::Resolution InitLookupCache::resolve(InitSection const& root, std::string const& path) {
+        // hits are answered from the path as given, without splitting it into components
+        auto& s = slot(root, path);
+        if (s.resolution.has_value()) {
+            statistics.hits++;
+            return *s.resolution;
+        }
+        statistics.misses++;
+        auto const components = InitSection::path_to_components(path);
+        s.resolution = const_cast<InitSection&>(root).canResolveHelper(std::begin(components), std::end(components));
+        return *s.resolution;
+    }
+
+    InitLookupCache::Resolution InitLookupCache::resolve(
+        InitSection const&              root,
+        std::vector<std::string> const& path
+    ) {
+        // a leading NUL keeps component lists apart from string paths, and NUL separators keep a
+        // component containing '/' apart from two components. The buffer keeps its capacity, so a
+        // hit allocates nothing
+        pathKey.clear();
+        for (auto const& component: path) {
+            pathKey.push_back('\0');
+            pathKey += component;
+        }
+        return resolve(root, pathKey, path);
+    }
+
+    std::optional<std::vector<std::string> > InitLookupCache::locate(InitSection const& root, std::string const& key) {
+        auto& s = slot(root, key);
+        if (!s.location.has_value()) {
+            statistics.misses++;
+            // not through getPathToEntry, whose statistics would count this lookup a second time
+            std::vector<std::string> path{};
+            if (root.getPathImpl(key, path)) {
+                std::ranges::reverse(path);
+                s.location.emplace(std::move(path));
+            } else {
+                s.location.emplace(std::nullopt);
+            }
+        } else {
+            statistics.hits++;
+        }
+        return *s.location;
+    }
+
+    InitLookupCache::Statistics const& InitLookupCache::stats() const noexcept {
+        return statistics;
+    }
+
+    std::size_t InitLookupCache::size() const noexcept {
+        return slots.size();
+    }
+
+    void InitLookupCache::clear() noexcept {
+        index.clear();
+        slots.clear();
+        owner = nullptr;
+    }
+} // namespace Init
@@ -0,0 +1,93 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITLOOKUPCACHE_H
+#define INITLOOKUPCACHE_H
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "InitSection.h"
+
+namespace Init {
+    /// A bounded cache of lookup results for one section tree, see `InitFile::enableLookupCache`.
+    /// Remembers the resolution of exact paths, including paths that do not resolve, and the
+    /// result of getPathToEntry for keys. Every result is dropped as soon as the tree reports a new
+    /// generation, so the cache never has to know which entries a change affected.
+    /// When it is full the least recently used path is evicted
+    class InitLookupCache {
+    public:
+        using Resolution = std::pair<InitSection::ResolutionType, void *>;
+
+        struct Statistics {
+            std::uint64_t hits{};
+            std::uint64_t misses{};
+            std::uint64_t evictions{};
+            /// times the cache was emptied because the tree changed
+            std::uint64_t invalidations{};
+
+            [[nodiscard]] double hitRate() const noexcept;
+        };
+
+    private:
+        struct Slot {
+            std::string                                              key;
+            std::optional<Resolution>                                resolution;
+            std::optional<std::optional<std::vector<std::string> > > location;
+        };
+
+        struct Hash {
+            std::size_t operator()(std::string_view key) const noexcept;
+        };
+
+        std::size_t                                                           capacity;
+        InitSection const                                                    *owner{};
+        std::uint64_t                                                         generation{};
+        // most recently used first. The index refers to the keys of the slots, which do not move
+        std::list<Slot>                                                       slots;
+        std::unordered_map<std::string_view, std::list<Slot>::iterator, Hash> index;
+        Statistics                                                            statistics;
+        // the key of the last component list looked up, kept so that building the next one does not allocate
+        std::string                                                           pathKey;
+
+        /// the slot for `key`, created if there is none. Empties the cache first if `root` is not
+        /// the tree, or not the generation of the tree, that the cache holds results for
+        Slot& slot(InitSection const& root, std::string_view key);
+
+        Resolution resolve(InitSection const& root, std::string_view key, std::vector<std::string> const& path);
+
+    public:
+        explicit InitLookupCache(std::size_t capacity);
+
+        /// a copy has the same capacity but starts out empty, as it is usually made along with a
+        /// copy of the tree that the original caches
+        InitLookupCache(InitLookupCache const& other);
+
+        InitLookupCache(InitLookupCache&& other) noexcept = default;
+
+        InitLookupCache& operator=(InitLookupCache const& other);
+
+        InitLookupCache& operator=(InitLookupCache&& other) noexcept = default;
+
+        [[nodiscard]] Resolution resolve(InitSection const& root, std::string const& path);
+
+        [[nodiscard]] Resolution resolve(InitSection const& root, std::vector<std::string> const& path);
+
+        [[nodiscard]] std::optional<std::vector<std::string> > locate(InitSection const& root, std::string const& key);
+
+        [[nodiscard]] Statistics const& stats() const noexcept;
+
+        [[nodiscard]] std::size_t size() const noexcept;
+
+        void clear() noexcept;
+    };
+} // namespace Init
+
+#endif // INITLOOKUPCACHE_H
@@ -0,0 +1,90 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitName.h"
+
+#include <functional>
+
+namespace Init {
+    std::size_t InitName::Hash::operator()(std::string_view text) const noexcept {
+        return std::hash<std::string_view>{}(text);
+    }
+
+    InitName::Record *InitName::empty_record() noexcept {
+        // never released: the count starts at one for the record itself
+        static Record empty{{1}, std::hash<std::string_view>{}({}), {}};
+        return &empty;
+    }
+
+    void InitName::release() noexcept {
+        if (record->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete record;
+        }
+    }
+
+    InitName::InitName() noexcept : record(empty_record()) {
+        record->references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    InitName::InitName(std::string_view text) : record(
+        text.empty()
+            ? empty_record()
+            : new Record{{0}, std::hash<std::string_view>{}(text), std::string{text}}
+    ) {
+        record->references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    InitName::InitName(InitName const& other) noexcept : record(other.record) {
+        record->references.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    InitName::InitName(InitName&& other) noexcept : InitName(static_cast<InitName const&>(other)) {
+        // a moved from name stays valid, so moving is copying
+    }
+
+    InitName& InitName::operator=(InitName const& other) noexcept {
+        other.record->references.fetch_add(1, std::memory_order_relaxed);
+        release();
+        record = other.record;
+        return *this;
+    }
+
+    InitName& InitName::operator=(InitName&& other) noexcept {
+        return *this = static_cast<InitName const&>(other);
+    }
+
+    InitName::~InitName() {
+        release();
+    }
+
+    InitName InitNamePool::intern(std::string_view text) {
+        if (auto const found = names.find(text); found != names.end()) {
+            return *found;
+        }
+        return *names.emplace(text).first;
+    }
+
+    InitName InitNamePool::intern(InitName const& name) {
+        return *names.insert(name).first;
+    }
+
+    std::size_t InitNamePool::size() const noexcept {
+        return names.size();
+    }
+
+    std::size_t InitNamePool::memoryFootprint() const noexcept {
+        std::size_t bytes = sizeof(InitNamePool) + names.bucket_count() * sizeof(void *);
+        for (auto const& name: names) {
+            // the set node and the record
+            bytes += sizeof(void *) + sizeof(InitName) + sizeof(InitName::Record) + name.size();
+        }
+        return bytes;
+    }
+
+    void InitNamePool::prune() {
+        std::erase_if(names, [](InitName const& name) {
+            return name.record->references.load(std::memory_order_acquire) == 1;
+        });
+    }
+} // namespace Init
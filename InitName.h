@@ -0,0 +1,162 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITNAME_H
+#define INITNAME_H
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace Init {
+    /// An immutable section name or entry key. Copies share one reference counted record holding
+    /// the text and its hash, so a name costs a pointer wherever it is stored, hashing it is free and
+    /// names from the same InitNamePool compare equal exactly when they are the same record.
+    /// Converts to the std::string and std::string_view it holds so it can be used as either
+    class InitName {
+        struct Record {
+            std::atomic<std::size_t> references;
+            std::size_t              hash;
+            std::string              text;
+        };
+
+        Record *record;
+
+        friend class InitNamePool;
+
+        static Record *empty_record() noexcept;
+
+        void release() noexcept;
+
+    public:
+        /// the empty name
+        InitName() noexcept;
+
+        /// a name of its own, not shared with any other. Use InitNamePool::intern to share
+        explicit InitName(std::string_view text);
+
+        InitName(InitName const& other) noexcept;
+
+        InitName(InitName&& other) noexcept;
+
+        InitName& operator=(InitName const& other) noexcept;
+
+        InitName& operator=(InitName&& other) noexcept;
+
+        ~InitName();
+
+        [[nodiscard]] std::string const& str() const noexcept {
+            return record->text;
+        }
+
+        [[nodiscard]] std::string_view view() const noexcept {
+            return record->text;
+        }
+
+        // NOLINTNEXTLINE(google-explicit-constructor)
+        operator std::string const&() const noexcept {
+            return record->text;
+        }
+
+        // NOLINTNEXTLINE(google-explicit-constructor)
+        operator std::string_view() const noexcept {
+            return record->text;
+        }
+
+        [[nodiscard]] std::size_t hash() const noexcept {
+            return record->hash;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return record->text.size();
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return record->text.empty();
+        }
+
+        /// whether `other` shares this name's record, as every copy of an interned name does
+        [[nodiscard]] bool same(InitName const& other) const noexcept {
+            return record == other.record;
+        }
+
+        friend bool operator==(InitName const& a, InitName const& b) noexcept {
+            return a.record == b.record || (a.record->hash == b.record->hash && a.record->text == b.record->text);
+        }
+
+        friend bool operator==(InitName const& a, std::string_view b) noexcept {
+            return a.record->text == b;
+        }
+
+        friend bool operator==(InitName const& a, std::string const& b) noexcept {
+            return a.record->text == b;
+        }
+
+        friend bool operator==(InitName const& a, char const *b) noexcept {
+            return a.record->text == b;
+        }
+
+        friend auto operator<=>(InitName const& a, InitName const& b) noexcept {
+            return a.record->text <=> b.record->text;
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, InitName const& name) {
+            return os << name.record->text;
+        }
+
+        /// hashes names by their precomputed hash and strings the same way, so maps keyed by
+        /// InitName can be searched with a std::string or std::string_view
+        struct Hash {
+            using is_transparent = void;
+
+            std::size_t operator()(InitName const& name) const noexcept {
+                return name.hash();
+            }
+
+            std::size_t operator()(std::string_view text) const noexcept;
+        };
+
+        struct Equal {
+            using is_transparent = void;
+
+            bool operator()(InitName const& a, InitName const& b) const noexcept {
+                return a == b;
+            }
+
+            bool operator()(InitName const& a, std::string_view b) const noexcept {
+                return a == b;
+            }
+
+            bool operator()(std::string_view a, InitName const& b) const noexcept {
+                return b == a;
+            }
+        };
+    };
+
+    /// The set of names used by one section tree. `parse` and the mutators of InitSection intern
+    /// every key and section name they store, so a name repeated across many sections is stored
+    /// once. The pool is owned by the root section; names stay valid after the pool is gone
+    class InitNamePool {
+        std::unordered_set<InitName, InitName::Hash, InitName::Equal> names;
+
+    public:
+        /// the shared name for `text`, added to the pool if it is not there yet
+        [[nodiscard]] InitName intern(std::string_view text);
+
+        [[nodiscard]] InitName intern(InitName const& name);
+
+        /// number of distinct names in the pool
+        [[nodiscard]] std::size_t size() const noexcept;
+
+        /// bytes used by the pool and its names
+        [[nodiscard]] std::size_t memoryFootprint() const noexcept;
+
+        /// drops the names that nothing but the pool refers to any more
+        void prune();
+    };
+} // namespace Init
+
+#endif // INITNAME_H
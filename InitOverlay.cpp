@@ -0,0 +1,135 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitOverlay.h"
+
+#include <functional>
+#include <utility>
+
+#include "InitException.h"
+
+namespace Init {
+    std::size_t InitOverlay::PathHash::operator()(std::vector<std::string> const& path) const noexcept {
+        std::size_t h = path.size();
+        for (auto const& component: path) {
+            h ^= std::hash<std::string>{}(component) + 0x9e3779b97f4a7c15uz + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+
+    InitOverlay::InitOverlay() = default;
+
+    InitOverlay::InitOverlay(std::vector<InitFile const *> layers) : layers(std::move(layers)) {}
+
+    void InitOverlay::push(InitFile const& layer) {
+        layers.push_back(&layer);
+    }
+
+    void InitOverlay::pop() {
+        if (!layers.empty()) {
+            layers.pop_back();
+        }
+    }
+
+    std::size_t InitOverlay::size() const noexcept {
+        return layers.size();
+    }
+
+    void InitOverlay::validateCache() const {
+        bool stale = seenGenerations.size() != layers.size();
+        if (!stale) {
+            for (std::size_t i = 0; i < layers.size(); i++) {
+                if (layers[i]->sections().generation() != seenGenerations[i]) {
+                    stale = true;
+                    break;
+                }
+            }
+        }
+        if (stale) {
+            cache.clear();
+            seenGenerations.resize(layers.size());
+            for (std::size_t i = 0; i < layers.size(); i++) {
+                seenGenerations[i] = layers[i]->sections().generation();
+            }
+        }
+    }
+
+    InitOverlay::Resolution InitOverlay::resolve(std::vector<std::string> const& path) const {
+        validateCache();
+        if (auto const cached = cache.find(path); cached != cache.end()) {
+            return cached->second;
+        }
+        Resolution result{InitSection::ResolutionType::NONE, nullptr};
+        for (std::size_t i = layers.size(); i-- > 0;) {
+            // resolution never modifies the section, this mirrors InitSection::canResolve
+            auto& root = const_cast<InitSection&>(layers[i]->sections());
+            if (auto res = root.canResolveHelper(std::begin(path), std::end(path));
+                res.first != InitSection::ResolutionType::NONE) {
+                result = res;
+                break;
+            }
+        }
+        cache.emplace(path, result);
+        return result;
+    }
+
+    std::optional<std::string> InitOverlay::getEntry(std::string const& key) const {
+        for (std::size_t i = layers.size(); i-- > 0;) {
+            if (auto value = layers[i]->sections().getEntry(key); value.has_value()) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+
+    InitSection::ResolutionType InitOverlay::canResolve(std::string const& path) const {
+        return canResolve(InitSection::path_to_components(path));
+    }
+
+    InitSection::ResolutionType InitOverlay::canResolve(std::vector<std::string> const& path) const {
+        return resolve(path).first;
+    }
+
+    bool InitOverlay::hasEntryExact(std::string const& path) const {
+        return canResolve(path) == InitSection::ResolutionType::ENTRY;
+    }
+
+    bool InitOverlay::hasEntryExact(std::vector<std::string> const& path) const {
+        return canResolve(path) == InitSection::ResolutionType::ENTRY;
+    }
+
+    InitEntry const& InitOverlay::getEntryExact(std::string const& path) const {
+        return getEntryExact(InitSection::path_to_components(path));
+    }
+
+    InitEntry const& InitOverlay::getEntryExact(std::vector<std::string> const& path) const {
+        switch (auto [kind, ptr] = resolve(path); kind) {
+            case InitSection::ResolutionType::NONE:
+                throw MissingEntry("InitOverlay::getEntryExact: no such entry");
+            case InitSection::ResolutionType::SECTION:
+                throw InitException("InitOverlay::getEntryExact: can't get section ");
+            case InitSection::ResolutionType::ENTRY:
+                return *static_cast<InitEntry const *>(ptr);
+            default:
+                throw std::runtime_error("InitOverlay::getEntryExact: unknown branch");
+        }
+    }
+
+    InitSection const& InitOverlay::getSectionExact(std::string const& path) const {
+        return getSectionExact(InitSection::path_to_components(path));
+    }
+
+    InitSection const& InitOverlay::getSectionExact(std::vector<std::string> const& path) const {
+        switch (auto [kind, ptr] = resolve(path); kind) {
+            case InitSection::ResolutionType::NONE:
+                throw MissingEntry("InitOverlay::getSectionExact: no such section");
+            case InitSection::ResolutionType::SECTION:
+                return *static_cast<InitSection const *>(ptr);
+            case InitSection::ResolutionType::ENTRY:
+                throw InitException("InitOverlay::getSectionExact: can't get entry ");
+            default:
+                throw std::runtime_error("InitOverlay::getSectionExact: unknown branch");
+        }
+    }
+} // namespace Init
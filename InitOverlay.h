@@ -0,0 +1,125 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITOVERLAY_H
+#define INITOVERLAY_H
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "InitFile.h"
+#include "InitSection.h"
+
+namespace Init {
+    /// A read-only view over a stack of InitFiles. Lookups are answered by the highest priority
+    /// layer that can resolve them, so a base config can be combined with environment and host
+    /// overrides without copying any entries between trees.
+    ///
+    /// The view does not own its layers: every InitFile pushed must outlive the overlay.
+    /// Resolved paths are cached until one of the layers reports a new generation, so a layer
+    /// may be modified or re-parsed in place at any time.
+    class InitOverlay {
+        struct PathHash {
+            std::size_t operator()(std::vector<std::string> const& path) const noexcept;
+        };
+
+        using Resolution = std::pair<InitSection::ResolutionType, void *>;
+
+        // lowest priority first, the last layer pushed wins
+        std::vector<InitFile const *> layers;
+
+        mutable std::vector<std::uint64_t>                                         seenGenerations;
+        mutable std::unordered_map<std::vector<std::string>, Resolution, PathHash> cache;
+
+        void validateCache() const;
+
+        [[nodiscard]] Resolution resolve(std::vector<std::string> const& path) const;
+
+        template <class Callable>
+        static void visitLayer(
+            InitSection const&                      section,
+            std::vector<InitSection const *> const& shadows,
+            Callable&                               l
+        ) {
+            for (auto const& [key, entry]: section.entries) {
+                bool shadowed = false;
+                for (auto const *shadow: shadows) {
+                    if (shadow != nullptr && shadow->entries.contains(key)) {
+                        shadowed = true;
+                        break;
+                    }
+                }
+                if (!shadowed) {
+                    l(entry);
+                }
+            }
+            std::vector<InitSection const *> next(shadows.size());
+            for (auto const& [name, subsection]: section.subsections) {
+                for (std::size_t i = 0; i < shadows.size(); i++) {
+                    auto const *shadow = shadows[i];
+                    if (shadow == nullptr) {
+                        next[i] = nullptr;
+                        continue;
+                    }
+                    auto const found = shadow->subsections.find(name);
+                    next[i]          = found == shadow->subsections.end() ? nullptr : &found->second;
+                }
+                visitLayer(subsection, next, l);
+            }
+        }
+
+    public:
+        InitOverlay();
+
+        /// layers are given lowest priority first
+        explicit InitOverlay(std::vector<InitFile const *> layers);
+
+        /// adds `layer` on top of the stack so that it overrides every layer already present
+        void push(InitFile const& layer);
+
+        /// removes the highest priority layer
+        void pop();
+
+        [[nodiscard]] std::size_t size() const noexcept;
+
+        /// looks up `key` in the default section of each layer
+        [[nodiscard]] std::optional<std::string> getEntry(std::string const& key) const;
+
+        [[nodiscard]] InitSection::ResolutionType canResolve(std::string const& path) const;
+
+        [[nodiscard]] InitSection::ResolutionType canResolve(std::vector<std::string> const& path) const;
+
+        [[nodiscard]] bool hasEntryExact(std::string const& path) const;
+
+        [[nodiscard]] bool hasEntryExact(std::vector<std::string> const& path) const;
+
+        [[nodiscard]] InitEntry const& getEntryExact(std::string const& path) const;
+
+        [[nodiscard]] InitEntry const& getEntryExact(std::vector<std::string> const& path) const;
+
+        /// returns the section from the highest priority layer that has it. The section itself
+        /// belongs to that layer, so lookups made through it are not merged with the other layers
+        [[nodiscard]] InitSection const& getSectionExact(std::string const& path) const;
+
+        [[nodiscard]] InitSection const& getSectionExact(std::vector<std::string> const& path) const;
+
+        /// calls `l` once for every entry visible through the overlay, i.e. every entry that is not
+        /// overridden by an entry at the same path in a higher priority layer
+        template <typename Callable> requires std::is_invocable_v<Callable, InitEntry const&>
+        void visit(Callable l) const {
+            for (std::size_t i = layers.size(); i-- > 0;) {
+                std::vector<InitSection const *> shadows{};
+                shadows.reserve(layers.size() - i - 1);
+                for (std::size_t j = i + 1; j < layers.size(); j++) {
+                    shadows.push_back(&layers[j]->sections());
+                }
+                visitLayer(layers[i]->sections(), shadows, l);
+            }
+        }
+    };
+} // namespace Init
+
+#endif // INITOVERLAY_H
@@ -0,0 +1,164 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitParallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace Init::Parallel {
+    namespace {
+        /// the threads every call to `run` shares. They are started the first time something runs in
+        /// parallel and wait for work in between, so a call costs a few queue operations rather than
+        /// starting and joining threads
+        class WorkerPool {
+            std::mutex                         lock;
+            std::condition_variable_any        queued;
+            std::deque<std::function<void()> > jobs;
+            std::vector<std::jthread>          workers;
+
+            void work(std::stop_token const& stop) {
+                while (true) {
+                    std::unique_lock guard{lock};
+                    if (!queued.wait(guard, stop, [this] { return !jobs.empty(); })) {
+                        return;
+                    }
+                    auto job = std::move(jobs.front());
+                    jobs.pop_front();
+                    guard.unlock();
+                    job();
+                }
+            }
+
+        public:
+            explicit WorkerPool(std::size_t threads) {
+                workers.reserve(threads);
+                for (std::size_t i = 0; i < threads; i++) {
+                    workers.emplace_back([this](std::stop_token const& stop) { work(stop); });
+                }
+            }
+
+            [[nodiscard]] std::size_t size() const noexcept {
+                return workers.size();
+            }
+
+            void submit(std::function<void()> job) {
+                {
+                    std::lock_guard const guard{lock};
+                    jobs.push_back(std::move(job));
+                }
+                queued.notify_one();
+            }
+
+            /// one thread for every hardware thread but the caller's, which works alongside them
+            static WorkerPool& shared() {
+                static WorkerPool pool{std::max(1u, std::thread::hardware_concurrency()) - 1};
+                return pool;
+            }
+        };
+
+        /// the state of one call to `run` that the pool threads helping with it share
+        struct Helpers {
+            std::atomic<std::size_t> next{0};
+            std::atomic<bool>        failed{false};
+            std::exception_ptr       error{};
+            std::mutex               lock{};
+            std::condition_variable  idle{};
+            std::size_t              active{};
+            bool                     closed{};
+        };
+    } // namespace
+
+    static std::size_t grain(std::size_t items, ParallelOptions const& options) noexcept {
+        if (options.grain != 0) {
+            return options.grain;
+        }
+        // aim for a few hundred items: enough to balance uneven callbacks over many cores without
+        // the bookkeeping showing up for cheap ones
+        return std::clamp<std::size_t>(items / 256, 16, 4096);
+    }
+
+    std::size_t chunks(std::size_t items, ParallelOptions const& options) noexcept {
+        auto const g = grain(items, options);
+        return (items + g - 1) / g;
+    }
+
+    void run(
+        std::size_t                                                                        items,
+        ParallelOptions const&                                                             options,
+        std::function<void(std::size_t chunk, std::size_t begin, std::size_t end)> const& work
+    ) {
+        auto const g     = grain(items, options);
+        auto const total = chunks(items, options);
+
+        if (items < options.serial || total <= 1 || options.threads == 1) {
+            for (std::size_t c = 0; c < total; c++) {
+                work(c, c * g, std::min(items, (c + 1) * g));
+            }
+            return;
+        }
+
+        auto&      pool  = WorkerPool::shared();
+        auto       count = options.threads != 0 ? options.threads : pool.size() + 1;
+        count            = std::min({count, total, pool.size() + 1});
+
+        auto const shared = std::make_shared<Helpers>();
+        auto const worker = [&, &state = *shared] {
+            while (!state.failed.load(std::memory_order_relaxed)) {
+                auto const c = state.next.fetch_add(1, std::memory_order_relaxed);
+                if (c >= total) {
+                    return;
+                }
+                try {
+                    work(c, c * g, std::min(items, (c + 1) * g));
+                } catch (...) {
+                    std::lock_guard const lock{state.lock};
+                    if (!state.error) {
+                        state.error = std::current_exception();
+                    }
+                    state.failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        for (std::size_t i = 1; i < count; i++) {
+            pool.submit([shared, &worker] {
+                {
+                    // a helper that only starts once the caller has finished has nothing left to do,
+                    // and the caller no longer waits for it: `worker` may already be gone
+                    std::lock_guard const lock{shared->lock};
+                    if (shared->closed) {
+                        return;
+                    }
+                    shared->active++;
+                }
+                worker();
+                std::lock_guard const lock{shared->lock};
+                if (--shared->active == 0) {
+                    shared->idle.notify_all();
+                }
+            });
+        }
+        // the caller claims work items too, so everything gets done even when every pool thread is
+        // busy, including with the callbacks of an enclosing run
+        worker();
+        {
+            std::unique_lock lock{shared->lock};
+            shared->closed = true;
+            shared->idle.wait(lock, [&] { return shared->active == 0; });
+        }
+
+        if (shared->error) {
+            std::rethrow_exception(shared->error);
+        }
+    }
+} // namespace Init::Parallel
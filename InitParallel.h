@@ -0,0 +1,40 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITPARALLEL_H
+#define INITPARALLEL_H
+#include <cstddef>
+#include <functional>
+
+namespace Init {
+    /// how `InitSection::parallel_visit` and `parallel_reduce` split up their work
+    struct ParallelOptions {
+        /// number of threads to use, including the calling thread. 0 uses every hardware thread. The
+        /// threads besides the caller come from a pool shared by every call, so at most that many are used
+        std::size_t threads{};
+        /// number of entries in each work item. 0 picks a size from the number of entries alone, so
+        /// the work items, and with them the result of a reduction, never depend on the thread count
+        std::size_t grain{};
+        /// with fewer entries than this every work item runs on the calling thread, where handing
+        /// them to other threads would cost more than the callbacks
+        std::size_t serial{1024};
+    };
+
+    namespace Parallel {
+        /// the number of work items `run` splits `items` into
+        [[nodiscard]] std::size_t chunks(std::size_t items, ParallelOptions const& options) noexcept;
+
+        /// calls `work(chunk, begin, end)` once for every work item, spread over the calling thread and
+        /// threads of a shared pool. Threads claim the next unclaimed item as they finish one, so uneven
+        /// callbacks still keep every thread busy. The first exception thrown stops items from being
+        /// claimed and is rethrown once every thread has finished. `work` may call `run` itself
+        void run(
+            std::size_t                                                    items,
+            ParallelOptions const&                                         options,
+            std::function<void(std::size_t chunk, std::size_t begin, std::size_t end)> const& work
+        );
+    } // namespace Parallel
+} // namespace Init
+
+#endif // INITPARALLEL_H
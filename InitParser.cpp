@@ -0,0 +1,63 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitParser.h"
+#include "InitException.h"
+
+#include <utility>
+
+namespace Init {
+    InitParser::InitParser(std::size_t maxLineLength) : maxLineLength(maxLineLength) {
+        secstack.push_back(&file.defaultSection);
+    }
+
+    void InitParser::parse(std::string_view line) {
+        if (auto const diagnostic = InitFile::parse_line(line, secstack, subsectionLevel); diagnostic.has_value()) {
+            InitFile::raise(*diagnostic);
+        }
+        lineCount++;
+    }
+
+    void InitParser::feed(std::string_view chunk) {
+        for (auto end = chunk.find('\n'); end != std::string_view::npos; end = chunk.find('\n')) {
+            if (pending.size() + end > maxLineLength) {
+                throw ParseException("Line " + std::to_string(lineCount + 1) + " is too long");
+            }
+            if (pending.empty()) {
+                parse(chunk.substr(0, end));
+            } else {
+                pending.append(chunk.substr(0, end));
+                parse(pending);
+                pending.clear();
+            }
+            chunk.remove_prefix(end + 1);
+        }
+        if (pending.size() + chunk.size() > maxLineLength) {
+            throw ParseException("Line " + std::to_string(lineCount + 1) + " is too long");
+        }
+        pending.append(chunk);
+    }
+
+    InitFile InitParser::finish() {
+        // like getline, a last line with no newline is still a line
+        if (!pending.empty()) {
+            parse(pending);
+            pending.clear();
+        }
+        file.defaultSection.verifyInterpolation();
+        auto result = std::exchange(file, InitFile{});
+        secstack.assign(1, &file.defaultSection);
+        subsectionLevel = 0;
+        lineCount       = 0;
+        return result;
+    }
+
+    std::size_t InitParser::lines() const noexcept {
+        return lineCount;
+    }
+
+    std::size_t InitParser::buffered() const noexcept {
+        return pending.size();
+    }
+} // namespace Init
@@ -0,0 +1,56 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITPARSER_H
+#define INITPARSER_H
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "InitFile.h"
+
+namespace Init {
+    /// Parses a file handed over in pieces of any size, as they arrive from a pipe or socket. Complete
+    /// lines are parsed as soon as their newline is fed; the only text held on to between calls is
+    /// the start of a line that has not ended yet, along with the open sections. The result is the
+    /// same tree `InitFile::parse` builds from the same text
+    class InitParser {
+        InitFile                   file;
+        std::vector<InitSection *> secstack;
+        int                        subsectionLevel{};
+        std::string                pending;
+        std::size_t                maxLineLength;
+        std::size_t                lineCount{};
+
+        void parse(std::string_view line);
+
+    public:
+        constexpr static std::size_t DEFAULT_MAX_LINE_LENGTH = 1024 * 1024;
+
+        /// lines longer than `maxLineLength` are rejected, which bounds how much is buffered
+        explicit InitParser(std::size_t maxLineLength = DEFAULT_MAX_LINE_LENGTH);
+
+        // the open sections point into `file`
+        InitParser(InitParser const&) = delete;
+
+        InitParser& operator=(InitParser const&) = delete;
+
+        /// parses every line that `chunk` completes. Throws the same exceptions as `parse` for an
+        /// invalid line, or ParseException for one that is too long; the parser can't be used after
+        void feed(std::string_view chunk);
+
+        /// parses the last line if it had no newline, checks the references as `parse` does and
+        /// returns the file. The parser is then ready to start on a new one
+        InitFile finish();
+
+        /// number of lines parsed so far
+        [[nodiscard]] std::size_t lines() const noexcept;
+
+        /// number of characters held back waiting for the end of their line
+        [[nodiscard]] std::size_t buffered() const noexcept;
+    };
+} // namespace Init
+
+#endif // INITPARSER_H
@@ -0,0 +1,240 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitQuery.h"
+
+#include <algorithm>
+
+#include "InitSection.h"
+
+namespace Init {
+    InitQuery::iterator::iterator() = default;
+
+    InitQuery::iterator::iterator(InitQuery *query, InitEntry const *current) : query(query), current(current) {}
+
+    InitQuery::iterator::reference InitQuery::iterator::operator*() const {
+        return *current;
+    }
+
+    InitQuery::iterator::pointer InitQuery::iterator::operator->() const {
+        return current;
+    }
+
+    InitQuery::iterator& InitQuery::iterator::operator++() {
+        current = query->next();
+        return *this;
+    }
+
+    void InitQuery::iterator::operator++(int) {
+        ++*this;
+    }
+
+    bool InitQuery::iterator::operator==(std::default_sentinel_t) const noexcept {
+        return current == nullptr;
+    }
+
+    InitQuery::InitQuery(InitSection const& scope, std::vector<std::string> pattern) : scope(&scope),
+                                                                                         pattern(std::move(pattern)) {
+        // consecutive ** match the same thing as a single one
+        auto const duplicate = std::ranges::unique(this->pattern, [](auto const& a, auto const& b) {
+            return a == "**" && b == "**";
+        });
+        this->pattern.erase(duplicate.begin(), duplicate.end());
+        if (this->pattern.empty()) {
+            return;
+        }
+
+        auto const globs = std::ranges::count(this->pattern, "**");
+        auto const& last = this->pattern.back();
+        if (globs > 0 && last != "*" && last != "**") {
+            // a ** can reach any depth, so rather than walking the whole subtree look at the entries
+            // with the requested key and check their paths
+            auto const& index = scope.keyIndex();
+            auto const  first = index.lower_bound({last, nullptr});
+            // the index covers the whole tree, so below the root a popular key can have more entries
+            // than the scope has altogether, and then walking the scope is cheaper
+            if (scope.parent() == nullptr || !rangeExceeds(first, index.end(), last, true, scope.sizeRecursive())) {
+                mode      = Mode::KEYS;
+                prefix    = last;
+                exact_key = true;
+                key_it    = first;
+                key_end   = index.end();
+                return;
+            }
+        }
+        // with more than one ** the same section can be reached along different routes
+        deduplicate = globs > 1;
+        frames.push_back({&scope, 0});
+    }
+
+    InitQuery::InitQuery(InitSection const& scope, KeyIndex const& index, std::string prefix) :
+            scope(&scope),
+            mode(Mode::KEYS),
+            key_it(index.lower_bound({prefix, nullptr})),
+            key_end(index.end()),
+            prefix(std::move(prefix)) {
+        if (scope.parent() != nullptr && rangeExceeds(key_it, key_end, this->prefix, false, scope.sizeRecursive())) {
+            // every entry beneath the scope, keeping those with the prefix
+            mode        = Mode::WALK;
+            walk_prefix = true;
+            pattern     = {"**"};
+            frames.push_back({&scope, 0});
+        }
+    }
+
+    bool InitQuery::rangeExceeds(
+        KeyIndex::const_iterator it,
+        KeyIndex::const_iterator end,
+        std::string_view         prefix,
+        bool                     exact,
+        std::size_t              limit
+    ) {
+        for (std::size_t count = 0; it != end; ++it, count++) {
+            if (exact ? it->first != prefix : !it->first.starts_with(prefix)) {
+                return false;
+            }
+            if (count == limit) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    InitQuery::iterator InitQuery::begin() {
+        return iterator{this, next()};
+    }
+
+    std::default_sentinel_t InitQuery::end() const noexcept {
+        return std::default_sentinel;
+    }
+
+    std::vector<InitEntry const *> InitQuery::collect() {
+        std::vector<InitEntry const *> result{};
+        for (auto const *e = next(); e != nullptr; e = next()) {
+            result.push_back(e);
+        }
+        return result;
+    }
+
+    InitEntry const *InitQuery::next() {
+        if (mode == Mode::KEYS) {
+            return nextKey();
+        }
+        auto const *e = nextWalk();
+        while (walk_prefix && e != nullptr && !e->key().starts_with(prefix)) {
+            e = nextWalk();
+        }
+        return e;
+    }
+
+    InitEntry const *InitQuery::nextWalk() {
+        while (true) {
+            while (next_pending < pending.size()) {
+                auto const *e = pending[next_pending++];
+                if (!deduplicate || seen.insert(e).second) {
+                    return e;
+                }
+            }
+            if (frames.empty()) {
+                return nullptr;
+            }
+
+            auto const [section, i] = frames.back();
+            frames.pop_back();
+            auto const& component = pattern[i];
+            bool const  last      = i + 1 == pattern.size();
+
+            pending.clear();
+            next_pending = 0;
+
+            if (component == "**") {
+                if (last) {
+                    // a trailing ** matches every entry beneath the section
+                    for (auto const& [key, entry]: section->entries) {
+                        pending.push_back(&entry);
+                    }
+                } else {
+                    // match no sections here and continue with the rest of the pattern
+                    frames.push_back({section, i + 1});
+                }
+                for (auto const& [name, subsection]: section->subsections) {
+                    frames.push_back({&subsection, i});
+                }
+                continue;
+            }
+
+            if (last) {
+                if (component == "*") {
+                    for (auto const& [key, entry]: section->entries) {
+                        pending.push_back(&entry);
+                    }
+                } else if (auto const found = section->entries.find(component); found != section->entries.end()) {
+                    pending.push_back(&found->second);
+                }
+                continue;
+            }
+
+            if (component == "*") {
+                for (auto const& [name, subsection]: section->subsections) {
+                    frames.push_back({&subsection, i + 1});
+                }
+            } else if (auto const found = section->subsections.find(component); found != section->subsections.end()) {
+                frames.push_back({&found->second, i + 1});
+            }
+        }
+    }
+
+    InitEntry const *InitQuery::nextKey() {
+        while (key_it != key_end) {
+            auto const [key, entry] = *key_it;
+            if (exact_key ? key != prefix : !key.starts_with(prefix)) {
+                key_it = key_end;
+                break;
+            }
+            ++key_it;
+            if (sectionsMatch(*entry)) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool InitQuery::sectionsMatch(InitEntry const& entry) {
+        names.clear();
+        for (auto const *s = entry.parent(); s != scope; s = s->m_parent) {
+            if (s == nullptr) {
+                // not beneath the section the query was made on
+                return false;
+            }
+            names.push_back(&s->name.str());
+        }
+        if (pattern.empty()) {
+            // prefix queries match anywhere beneath the scope
+            return true;
+        }
+        std::ranges::reverse(names);
+        return matchFrom(0, 0);
+    }
+
+    bool InitQuery::matchFrom(std::size_t p, std::size_t n) const {
+        // the last component of the pattern is the key which has already been matched
+        auto const sections = pattern.size() - 1;
+        while (p < sections) {
+            if (pattern[p] == "**") {
+                for (auto skip = n; skip <= names.size(); skip++) {
+                    if (matchFrom(p + 1, skip)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            if (n >= names.size() || (pattern[p] != "*" && pattern[p] != *names[n])) {
+                return false;
+            }
+            p++;
+            n++;
+        }
+        return n == names.size();
+    }
+} // namespace Init
@@ -0,0 +1,123 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITQUERY_H
+#define INITQUERY_H
+#include <cstddef>
+#include <iterator>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "InitEntry.h"
+
+namespace Init {
+    class InitSection;
+
+    /// A lazily evaluated sequence of the entries matching a path pattern or a key prefix. Queries are
+    /// created by `InitSection::query` and `InitSection::queryKeyPrefix`. Matches are found one at
+    /// a time as the query is iterated, so the cost depends on the number of matches rather than
+    /// on the size of the tree. Below the root it is at most the size of the scope.
+    ///
+    /// A query can be iterated once. The tree must not be modified while a query over it is being iterated
+    class InitQuery {
+    public:
+        /// every entry of a tree ordered by key. A root section builds one the first time a query
+        /// needs it and keeps it up to date as the tree is modified
+        using KeyIndex = std::set<std::pair<std::string_view, InitEntry *> >;
+
+        class iterator {
+            InitQuery       *query{};
+            InitEntry const *current{};
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = InitEntry;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = InitEntry const *;
+            using reference         = InitEntry const&;
+
+            iterator();
+
+            iterator(InitQuery *query, InitEntry const *current);
+
+            reference operator*() const;
+
+            pointer operator->() const;
+
+            iterator& operator++();
+
+            void operator++(int);
+
+            bool operator==(std::default_sentinel_t) const noexcept;
+        };
+
+        iterator begin();
+
+        [[nodiscard]] std::default_sentinel_t end() const noexcept;
+
+        /// collects the remaining matches
+        [[nodiscard]] std::vector<InitEntry const *> collect();
+
+    private:
+        friend class InitSection;
+
+        enum class Mode { WALK, KEYS };
+
+        struct Frame {
+            InitSection const *section;
+            std::size_t        index;
+        };
+
+        InitSection const       *scope{};
+        std::vector<std::string> pattern;
+        Mode                     mode{Mode::WALK};
+
+        // WALK: the section tree itself is the index over path components
+        std::vector<Frame>                    frames;
+        std::vector<InitEntry const *>        pending;
+        std::size_t                           next_pending{};
+        bool                                  deduplicate{};
+        std::unordered_set<InitEntry const *> seen;
+        // a prefix query over a subsection with fewer entries than the index has matching keys
+        bool                                  walk_prefix{};
+
+        // KEYS: a range of the root's key index filtered by the path pattern
+        KeyIndex::const_iterator         key_it;
+        KeyIndex::const_iterator         key_end;
+        std::string                      prefix;
+        bool                             exact_key{};
+        std::vector<std::string const *> names;
+
+        InitQuery(InitSection const& scope, std::vector<std::string> pattern);
+
+        InitQuery(InitSection const& scope, KeyIndex const& index, std::string prefix);
+
+        /// whether more than `limit` keys starting at `it` match `prefix` (all of it if `exact`), so that
+        /// walking `limit` entries beneath the scope costs less than filtering the range of the index
+        [[nodiscard]] static bool rangeExceeds(
+            KeyIndex::const_iterator it,
+            KeyIndex::const_iterator end,
+            std::string_view         prefix,
+            bool                     exact,
+            std::size_t              limit
+        );
+
+        InitEntry const *next();
+
+        InitEntry const *nextWalk();
+
+        InitEntry const *nextKey();
+
+        /// true if the sections leading from `scope` to `entry` match the section part of the pattern
+        bool sectionsMatch(InitEntry const& entry);
+
+        bool matchFrom(std::size_t p, std::size_t n) const;
+    };
+} // namespace Init
+
+#endif // INITQUERY_H
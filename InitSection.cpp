@@ -5,28 +5,16 @@
 #include "InitSection.h"
 
 #include <__filesystem/path.h>
+#include <atomic>
 #include <iostream>
-#include <numeric>
-#include <concepts>
 #include <algorithm>
 #include <utility>
 #include "InitEntry.h"
 #include "InitException.h"
 #include "InitFile.h"
+#include "InitStats.h"
 
 namespace Init {
-    namespace Private {
-        template <class L, class K, class V, class R>
-        concept map_operator = requires (L op, std::pair<K, V> pair, R result) {
-            { op(result, pair) } -> std::same_as<R>;
-        };
-
-        template <typename R, typename K, typename V, map_operator<K, V, R> Lambda>
-        R accumulate(std::unordered_map<K, V> const& vec, R init, Lambda operation) {
-            return std::accumulate(std::begin(vec), std::end(vec), init, operation);
-        }
-    }
-
     bool InitSection::getPathImpl(std::string const& key, std::vector<std::string>& path) const {
         if (entries.contains(key)) {
             // include key in path so it can be used in canResolve & updateEntryRecursive
@@ -44,26 +32,399 @@ namespace Init {
 
     InitSection::InitSection() = default;
 
-    InitSection::InitSection(std::string name) noexcept : name(std::move(name)) {}
+    InitSection::InitSection(std::string name) : name(name) {}
+
+    InitSection::InitSection(InitName name) noexcept : name(std::move(name)) {}
+
+    InitSection::InitSection(InitSection const& other) : name(other.name),
+                                                         entries(other.entries),
+                                                         subsections(other.subsections),
+                                                         m_totals(other.m_totals) {
+        adopt_children();
+    }
+
+    InitSection::InitSection(InitSection&& other) noexcept : name(std::move(other.name)),
+                                                             entries(std::move(other.entries)),
+                                                             subsections(std::move(other.subsections)),
+                                                             m_totals(other.m_totals) {
+        adopt_children();
+        other.m_totals = {};
+        if (other.m_parent != nullptr) {
+            // the contents left a section that is still part of a tree
+            if (auto *index = other.root()->m_keyIndex.get()) {
+                unindexFrom(*index);
+            }
+            other.m_parent->touch(other.asChild(), asChild());
+        } else {
+            m_keyIndex      = std::move(other.m_keyIndex);
+            m_subscriptions = std::move(other.m_subscriptions);
+            m_names         = std::move(other.m_names);
+        }
+    }
+
+    InitSection& InitSection::operator=(InitSection const& other) {
+        if (this != &other) {
+            auto const before = asChild();
+            auto *const index = root()->m_keyIndex.get();
+            if (index != nullptr) {
+                unindexFrom(*index);
+            }
+            // a section keeps its place in the tree: the parent is not copied
+            name        = other.name;
+            entries     = other.entries;
+            subsections = other.subsections;
+            m_totals    = other.m_totals;
+            adopt_children();
+            if (index != nullptr) {
+                indexInto(*index);
+            }
+            m_generation = next_generation();
+            if (m_parent != nullptr) {
+                m_parent->touch(asChild(), before);
+            }
+            // subscriptions belong to the place in the tree, not to the contents
+            notify(root(), InitChange::Type::UPDATED, nullptr);
+        }
+        return *this;
+    }
+
+    InitSection& InitSection::operator=(InitSection&& other) noexcept {
+        if (this != &other) {
+            auto const before = asChild();
+            if (auto *index = other.root()->m_keyIndex.get()) {
+                other.unindexFrom(*index);
+            }
+            name           = std::move(other.name);
+            entries        = std::move(other.entries);
+            subsections    = std::move(other.subsections);
+            m_totals       = other.m_totals;
+            other.m_totals = {};
+            adopt_children();
+            auto *const r = root();
+            // re-indexing would allocate, so the index of this tree is rebuilt on demand instead
+            r->m_keyIndex.reset();
+            if (m_parent == nullptr && other.m_parent == nullptr) {
+                m_subscriptions = std::move(other.m_subscriptions);
+                m_names         = std::move(other.m_names);
+            } else if (r != other.root()) {
+                try {
+                    if (!r->m_names) {
+                        r->m_names = std::make_unique<InitNamePool>();
+                    }
+                    shareNames(*r->m_names);
+                } catch (...) {
+                    // the names that are left unshared still compare and hash correctly
+                }
+            }
+            m_generation = next_generation();
+            if (m_parent != nullptr) {
+                m_parent->touch(asChild(), before);
+            }
+            if (other.m_parent != nullptr) {
+                other.m_parent->touch(other.asChild(), asChild());
+            }
+        }
+        return *this;
+    }
+
+    std::uint64_t InitSection::next_generation() noexcept {
+        static std::atomic<std::uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    void InitSection::adopt_children() noexcept {
+        for (auto& [key, entry]: entries) {
+            entry.m_parent = this;
+        }
+        for (auto& [key, section]: subsections) {
+            section.m_parent = this;
+        }
+    }
+
+    InitSection *InitSection::root() const noexcept {
+        auto s = const_cast<InitSection *>(this);
+        while (s->m_parent != nullptr) {
+            s = s->m_parent;
+        }
+        return s;
+    }
+
+    InitName InitSection::intern(std::string_view text) {
+        auto *const r = root();
+        if (!r->m_names) {
+            r->m_names = std::make_unique<InitNamePool>();
+        }
+        return r->m_names->intern(text);
+    }
+
+    void InitSection::shareNames(InitNamePool& pool) {
+        // intern everything first so that nothing is rekeyed unless all of it can be
+        std::vector<std::pair<decltype(entries)::iterator, InitName> >     entryKeys{};
+        std::vector<std::pair<decltype(subsections)::iterator, InitName> > sectionKeys{};
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (auto shared = pool.intern(it->first); !shared.same(it->first)) {
+                entryKeys.emplace_back(it, std::move(shared));
+            }
+        }
+        for (auto it = subsections.begin(); it != subsections.end(); ++it) {
+            if (auto shared = pool.intern(it->first); !shared.same(it->first)) {
+                sectionKeys.emplace_back(it, std::move(shared));
+            }
+        }
+        // putting a node back into the map it came from never rehashes, so iterators stay valid
+        for (auto& [it, shared]: entryKeys) {
+            auto node           = entries.extract(it);
+            node.key()          = shared;
+            node.mapped().m_key = std::move(shared);
+            entries.insert(std::move(node));
+        }
+        for (auto& [it, shared]: sectionKeys) {
+            auto node          = subsections.extract(it);
+            node.key()         = shared;
+            node.mapped().name = std::move(shared);
+            subsections.insert(std::move(node));
+        }
+        for (auto& [key, section]: subsections) {
+            section.shareNames(pool);
+        }
+    }
+
+    InitQuery::KeyIndex const& InitSection::keyIndex() const {
+        auto *const r = root();
+        if (!r->m_keyIndex) {
+            auto index = std::make_unique<InitQuery::KeyIndex>();
+            r->indexInto(*index);
+            r->m_keyIndex = std::move(index);
+        }
+        return *r->m_keyIndex;
+    }
+
+    void InitSection::indexInto(InitQuery::KeyIndex& index) const {
+        for (auto const& [key, entry]: entries) {
+            index.emplace(key, const_cast<InitEntry *>(&entry));
+        }
+        for (auto const& [key, section]: subsections) {
+            section.indexInto(index);
+        }
+    }
+
+    void InitSection::unindexFrom(InitQuery::KeyIndex& index) const noexcept {
+        for (auto const& [key, entry]: entries) {
+            index.erase({key, const_cast<InitEntry *>(&entry)});
+        }
+        for (auto const& [key, section]: subsections) {
+            section.unindexFrom(index);
+        }
+    }
+
+    InitSection::Totals InitSection::asChild() const noexcept {
+        auto t = m_totals;
+        t.sections += 1;
+        t.nameBytes += name.size();
+        return t;
+    }
+
+    InitSection *InitSection::touch(Totals const& added, Totals const& removed) noexcept {
+        auto const g = next_generation();
+        auto       r = this;
+        for (auto s = this; s != nullptr; r = s, s = s->m_parent) {
+            s->m_generation = g;
+            auto& t         = s->m_totals;
+            t.entries       = t.entries + added.entries - removed.entries;
+            t.sections      = t.sections + added.sections - removed.sections;
+            t.keyBytes      = t.keyBytes + added.keyBytes - removed.keyBytes;
+            t.valueBytes    = t.valueBytes + added.valueBytes - removed.valueBytes;
+            t.nameBytes     = t.nameBytes + added.nameBytes - removed.nameBytes;
+        }
+        return r;
+    }
+
+    void InitSection::notify(InitSection const *root, InitChange::Type type, std::string const *key) const {
+        auto *const subscriptions = root->m_subscriptions.get();
+        if (subscriptions == nullptr || subscriptions->empty()) {
+            return;
+        }
+        auto p = path();
+        if (key != nullptr) {
+            p.push_back(*key);
+        }
+        subscriptions->publish({type, key == nullptr, std::move(p)});
+    }
+
+    void InitSection::mergeFrom(InitSection const& other) {
+        std::vector<InitName> stale{};
+        for (auto const& [key, entry]: entries) {
+            if (!other.entries.contains(key)) {
+                stale.push_back(key);
+            }
+        }
+        for (auto const& key: stale) {
+            removeEntry(key);
+        }
+        for (auto const& [key, entry]: other.entries) {
+            if (auto *const mine = findEntry(key); mine == nullptr) {
+                insertEntry(InitEntry{key, entry.value()});
+            } else if (mine->value() != entry.value()) {
+                setEntryValue(*mine, entry.value());
+            }
+        }
+
+        stale.clear();
+        for (auto const& [key, section]: subsections) {
+            if (!other.subsections.contains(key)) {
+                stale.push_back(key);
+            }
+        }
+        for (auto const& key: stale) {
+            removeSubsection(key);
+        }
+        for (auto const& [key, section]: other.subsections) {
+            auto *mine = findSubsection(key);
+            if (mine == nullptr) {
+                mine = &createSubsection(key);
+            }
+            mine->mergeFrom(section);
+        }
+    }
+
+    std::vector<InitSection::InitSectionName> InitSection::path() const {
+        std::vector<InitSectionName> p{};
+        for (auto s = this; s->m_parent != nullptr; s = s->m_parent) {
+            p.push_back(s->name.str());
+        }
+        std::ranges::reverse(p);
+        return p;
+    }
+
+    InitSection::SubscriptionId InitSection::subscribe(
+        std::string const&          path,
+        InitSubscriptions::Callback callback
+    ) {
+        return subscribe(path_to_components(path), std::move(callback));
+    }
+
+    InitSection::SubscriptionId InitSection::subscribe(
+        std::vector<std::string> const& path,
+        InitSubscriptions::Callback     callback
+    ) {
+        auto *const r = root();
+        if (!r->m_subscriptions) {
+            r->m_subscriptions = std::make_unique<InitSubscriptions>();
+        }
+        auto full = this->path();
+        full.insert(full.end(), path.begin(), path.end());
+        return r->m_subscriptions->add(std::move(full), false, std::move(callback));
+    }
+
+    InitSection::SubscriptionId InitSection::subscribeSubtree(
+        std::string const&          path,
+        InitSubscriptions::Callback callback
+    ) {
+        return subscribeSubtree(path_to_components(path), std::move(callback));
+    }
+
+    InitSection::SubscriptionId InitSection::subscribeSubtree(
+        std::vector<std::string> const& path,
+        InitSubscriptions::Callback     callback
+    ) {
+        auto *const r = root();
+        if (!r->m_subscriptions) {
+            r->m_subscriptions = std::make_unique<InitSubscriptions>();
+        }
+        auto full = this->path();
+        full.insert(full.end(), path.begin(), path.end());
+        return r->m_subscriptions->add(std::move(full), true, std::move(callback));
+    }
+
+    bool InitSection::unsubscribe(SubscriptionId id) {
+        auto *const subscriptions = root()->m_subscriptions.get();
+        return subscriptions != nullptr && subscriptions->remove(id);
+    }
+
+    InitSection *InitSection::parent() const {
+        return m_parent;
+    }
+
+    std::uint64_t InitSection::generation() const noexcept {
+        return m_generation;
+    }
 
     void InitSection::createEntry(std::string const& key, std::string const& value) {
         addEntry(InitEntry(key, value));
     }
 
     void InitSection::addEntry(InitEntry const& entry) {
-        entries[entry.key()]          = entry;
-        entries[entry.key()].m_parent = this;
+        addEntry(InitEntry{entry});
     }
 
     void InitSection::addEntry(InitEntry&& entry) {
-        entry.m_parent       = this;
-        entries[entry.key()] = std::move(entry);
+        if (entry.m_value.find("${") == std::string::npos) {
+            insertEntry(std::move(entry));
+            return;
+        }
+        auto const *const existing = findEntry(entry.key());
+        auto              previous = existing == nullptr ? std::nullopt : std::make_optional(existing->value());
+        auto              key      = entry.key();
+        changeReferences([&]() -> InitEntry const& { return insertEntry(std::move(entry)); }, [&] {
+            if (previous.has_value()) {
+                setEntryValue(*findEntry(key), *previous);
+            } else {
+                removeEntry(key);
+            }
+        });
+    }
+
+    InitEntry& InitSection::insertEntry(InitEntry&& entry) {
+        Totals const added{1, 0, entry.key().size(), entry.value().size()};
+        Totals       removed{};
+        entry.m_key         = intern(entry.key());
+        auto [it, inserted] = entries.try_emplace(entry.m_key);
+        if (!inserted) {
+            removed = {1, 0, it->second.key().size(), it->second.value().size()};
+        }
+        entry.m_parent = this;
+        it->second     = std::move(entry);
+        auto *const r  = touch(added, removed);
+        if (inserted && r->m_keyIndex) {
+            r->m_keyIndex->emplace(it->first, &it->second);
+        }
+        notify(r, inserted ? InitChange::Type::ADDED : InitChange::Type::UPDATED, &it->first.str());
+        return it->second;
+    }
+
+    void InitSection::changeReferences(
+        std::function<InitEntry const&()> const& change,
+        std::function<void()> const&             undo
+    ) {
+        auto *const subscriptions = root()->m_subscriptions.get();
+        if (subscriptions != nullptr) {
+            subscriptions->beginBatch();
+        }
+        try {
+            auto const& entry = change();
+            try {
+                (void) entry.interpolated();
+            } catch (...) {
+                undo();
+                throw;
+            }
+        } catch (...) {
+            if (subscriptions != nullptr) {
+                subscriptions->abandonBatch();
+            }
+            throw;
+        }
+        if (subscriptions != nullptr) {
+            subscriptions->endBatch();
+        }
     }
 
     [[nodiscard]] std::optional<std::vector<InitSection::InitSectionName> >
     InitSection::getPathToEntry(std::string const& key) const {
+        Stats::LookupTimer           timer{Stats::Api::GET_PATH_TO_ENTRY};
         std::vector<InitSectionName> path{};
         if (getPathImpl(key, path)) {
+            timer.hit();
             std::ranges::reverse(path);
             return std::make_optional(path);
         }
@@ -93,7 +454,12 @@ namespace Init {
     }
 
     [[nodiscard]] InitSection::ResolutionType InitSection::canResolve(std::vector<std::string> const& path) const {
-        return const_cast<InitSection *>(this)->canResolveHelper(std::begin(path), std::end(path)).first;
+        Stats::LookupTimer timer{Stats::Api::CAN_RESOLVE};
+        auto const         kind = const_cast<InitSection *>(this)->canResolveHelper(std::begin(path), std::end(path)).first;
+        if (kind != ResolutionType::NONE) {
+            timer.hit();
+        }
+        return kind;
     }
 
     [[nodiscard]] InitEntry& InitSection::getEntryExact(std::string const& path) {
@@ -106,18 +472,40 @@ namespace Init {
     }
 
     InitEntry& InitSection::getEntryExact(std::vector<std::string> const& path) {
+        Stats::LookupTimer timer{Stats::Api::GET_ENTRY_EXACT};
         switch (auto [kind, ptr] = canResolveHelper(std::begin(path), std::end(path)); kind) {
             case ResolutionType::NONE:
                 throw MissingEntry("InitSection::getEntryExact: no such entry");
             case ResolutionType::SECTION:
                 throw InitException("InitSection::getEntryExact: can't get section ");
             case ResolutionType::ENTRY:
+                timer.hit();
                 return *static_cast<InitEntry *>(ptr);
             default:
                 throw std::runtime_error("InitSection::getEntryExact: unknown branch");
         }
     }
 
+    std::string const& InitSection::getEntryInterpolated(std::string const& path) const {
+        return getEntryExact(path).interpolated();
+    }
+
+    std::string const& InitSection::getEntryInterpolated(std::vector<std::string> const& path) const {
+        return getEntryExact(path).interpolated();
+    }
+
+    void InitSection::verifyInterpolation() const {
+        for (auto const& [name, entry]: entries) {
+            // a plain value can't fail and is left without the bookkeeping an expansion allocates
+            if (entry.value().find("${") != std::string::npos) {
+                (void) entry.interpolated();
+            }
+        }
+        for (auto const& [name, section]: subsections) {
+            section.verifyInterpolation();
+        }
+    }
+
     [[nodiscard]] InitSection& InitSection::getSectionExact(std::string const& path) {
         auto p = path_to_components(path);
         return getSectionExact(p);
@@ -140,22 +528,63 @@ namespace Init {
         }
     }
 
+    InitSection *InitSection::findSubsection(std::string const& name) noexcept {
+        auto const it = subsections.find(name);
+        return it == subsections.end() ? nullptr : &it->second;
+    }
+
+    InitEntry *InitSection::findEntry(std::string const& key) noexcept {
+        auto const it = entries.find(key);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
     InitSection& InitSection::createSubsection(std::string const& name) {
-        subsections[name] = InitSection{name};
-        return subsections[name];
+        auto key            = intern(name);
+        auto [it, inserted] = subsections.try_emplace(key, key);
+        auto& section       = it->second;
+        if (inserted) {
+            section.m_parent = this;
+            section.notify(touch(section.asChild(), {}), InitChange::Type::ADDED, nullptr);
+        } else {
+            // assigning over an existing subsection accounts for the replaced contents itself
+            section = InitSection{std::move(key)};
+            section.notify(root(), InitChange::Type::UPDATED, nullptr);
+        }
+        return section;
     }
 
     bool InitSection::removeSubsection(std::string const& name) {
-        if (subsections.contains(name)) {
-            subsections.erase(name);
+        if (auto const it = subsections.find(name); it != subsections.end()) {
+            auto const removed    = it->second.asChild();
+            auto *const r         = root();
+            bool const subscribed = r->m_subscriptions && !r->m_subscriptions->empty();
+            if (r->m_keyIndex) {
+                it->second.unindexFrom(*r->m_keyIndex);
+            }
+            std::vector<std::string> p{};
+            if (subscribed) {
+                p = it->second.path();
+            }
+            subsections.erase(it);
+            touch({}, removed);
+            if (subscribed) {
+                r->m_subscriptions->publish({InitChange::Type::REMOVED, true, std::move(p)});
+            }
             return true;
         }
         return false;
     }
 
     bool InitSection::removeEntry(std::string const& key) {
-        if (entries.contains(key)) {
-            entries.erase(key);
+        if (auto const it = entries.find(key); it != entries.end()) {
+            Totals const removed{1, 0, it->second.key().size(), it->second.value().size()};
+            auto *const r = root();
+            if (r->m_keyIndex) {
+                r->m_keyIndex->erase({it->first, &it->second});
+            }
+            entries.erase(it);
+            touch({}, removed);
+            notify(r, InitChange::Type::REMOVED, &key);
             return true;
         }
         return false;
@@ -170,12 +599,20 @@ namespace Init {
     }
 
     [[nodiscard]] std::optional<std::string> InitSection::getEntry(std::string const& key) const {
-        if (entries.contains(key)) {
-            return std::make_optional(entries.at(key).value());
+        if (auto const it = entries.find(key); it != entries.end()) {
+            return std::make_optional(it->second.value());
         }
         return std::nullopt;
     }
 
+    InitQuery InitSection::query(std::string const& pattern) const {
+        return InitQuery{*this, path_to_components(pattern)};
+    }
+
+    InitQuery InitSection::queryKeyPrefix(std::string const& prefix) const {
+        return InitQuery{*this, keyIndex(), prefix};
+    }
+
     [[nodiscard]] std::vector<InitEntry> InitSection::getAllEntries() const {
         std::vector<InitEntry> s{};
         s.reserve(entries.size());
@@ -199,13 +636,71 @@ namespace Init {
     }
 
 
+    void InitSection::setEntryValue(InitEntry& entry, std::string const& value) {
+        Totals const removed{0, 0, 0, entry.value().size()};
+        entry.setValue(value);
+        notify(touch({0, 0, 0, value.size()}, removed), InitChange::Type::UPDATED, &entry.key());
+    }
+
+    InitSection::VisitSnapshot InitSection::snapshot(std::vector<InitEntry *> const& visited) const {
+        VisitSnapshot before{};
+        before.sizes.reserve(visited.size());
+        for (auto const *entry: visited) {
+            before.sizes.push_back(entry->value().size());
+        }
+        if (auto const *subscriptions = root()->m_subscriptions.get();
+            subscriptions != nullptr && !subscriptions->empty()) {
+            before.values.reserve(visited.size());
+            for (auto const *entry: visited) {
+                before.values.push_back(entry->value());
+            }
+        }
+        return before;
+    }
+
+    void InitSection::reconcile(std::vector<InitEntry *> const& visited, VisitSnapshot const& before) {
+        auto *const r             = root();
+        auto *const subscriptions = before.values.empty() ? nullptr : r->m_subscriptions.get();
+        if (subscriptions != nullptr) {
+            subscriptions->beginBatch();
+        }
+        // the entries of a section are next to each other in `visited`, so each section is touched once
+        for (std::size_t i = 0; i < visited.size();) {
+            auto *const section = visited[i]->m_parent;
+            Totals      added{};
+            Totals      removed{};
+            for (; i < visited.size() && visited[i]->m_parent == section; i++) {
+                auto const& entry = *visited[i];
+                added.valueBytes += entry.value().size();
+                removed.valueBytes += before.sizes[i];
+                entry.invalidate();
+                if (subscriptions != nullptr && entry.value() != before.values[i]) {
+                    section->notify(r, InitChange::Type::UPDATED, &entry.key());
+                }
+            }
+            section->touch(added, removed);
+        }
+        if (subscriptions != nullptr) {
+            subscriptions->endBatch();
+        }
+    }
+
     bool InitSection::updateEntry(std::string const& key, std::string const& value) {
-        if (entries.contains(key)) {
-            std::cout << key << std::endl;
-            entries.at(key).value() = value;
+        auto const it = entries.find(key);
+        if (it == entries.end()) {
+            return false;
+        }
+        auto& entry = it->second;
+        if (value.find("${") == std::string::npos) {
+            setEntryValue(entry, value);
             return true;
         }
-        return false;
+        std::string const previous = entry.m_value;
+        changeReferences([&]() -> InitEntry const& {
+            setEntryValue(entry, value);
+            return entry;
+        }, [&] { setEntryValue(entry, previous); });
+        return true;
     }
 
     std::vector<std::string> InitSection::path_to_components(std::string const& path) {
@@ -253,18 +748,47 @@ namespace Init {
     }
 
     [[nodiscard]] std::size_t InitSection::sizeRecursive() const noexcept {
-        using Private::accumulate;
-        return entries.size() + accumulate(
-                   subsections, 0uz, [] (auto acc, auto const& s) { return acc + s.second.sizeRecursive(); }
-               );
+        return m_totals.entries;
+    }
+
+    std::size_t InitSection::subsectionCountRecursive() const noexcept {
+        return m_totals.sections;
+    }
+
+    std::size_t InitSection::keyBytesRecursive() const noexcept {
+        return m_totals.keyBytes;
+    }
+
+    std::size_t InitSection::valueBytesRecursive() const noexcept {
+        return m_totals.valueBytes;
+    }
+
+    std::size_t InitSection::memoryFootprint() const noexcept {
+        // every entry and subsection lives in a map node next to its name, and the names themselves
+        // are shared through the pool of the root. Without a pool every name is counted on its own
+        auto const structure = sizeof(InitSection) + m_totals.entries * (sizeof(InitName) + sizeof(InitEntry))
+                               + m_totals.sections * (sizeof(InitName) + sizeof(InitSection)) + m_totals.valueBytes;
+        if (m_parent == nullptr && m_names) {
+            return structure + m_names->memoryFootprint();
+        }
+        return structure + name.size() + m_totals.keyBytes + m_totals.nameBytes;
+    }
+
+    std::size_t InitSection::internedNames() const noexcept {
+        auto const *const r = root();
+        return r->m_names ? r->m_names->size() : 0;
     }
 
     [[nodiscard]] InitSection const& InitSection::getSubsection(std::string const& key) const {
-        return subsections.at(key);
+        return const_cast<InitSection *>(this)->getSubsection(key);
     }
 
     [[nodiscard]] InitSection& InitSection::getSubsection(std::string const& key) {
-        return subsections.at(key);
+        auto *const section = findSubsection(key);
+        if (section == nullptr) {
+            throw std::out_of_range("InitSection::getSubsection: no such section");
+        }
+        return *section;
     }
 
     void InitSection::print_with_escapes(std::ostream &os, std::string const& s) {
@@ -4,11 +4,22 @@
 
 #ifndef INITSECTION_H
 #define INITSECTION_H
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "InitEntry.h"
+#include "InitName.h"
+#include "InitParallel.h"
+#include "InitQuery.h"
+#include "InitSubscriptions.h"
 
 namespace Init {
     class InitSection {
@@ -18,9 +29,65 @@ namespace Init {
         constexpr static std::string DEFAULT_NAME = "<default>";
 
     private:
-        std::string                                  name{DEFAULT_NAME};
-        std::unordered_map<std::string, InitEntry>   entries;
-        std::unordered_map<std::string, InitSection> subsections;
+        InitName                                                                    name{DEFAULT_NAME};
+        std::unordered_map<InitName, InitEntry, InitName::Hash, InitName::Equal>   entries;
+        std::unordered_map<InitName, InitSection, InitName::Hash, InitName::Equal> subsections;
+
+        /// aggregate counts for everything beneath a section, kept up to date by every mutator so
+        /// that size and memory queries do not have to walk the tree
+        struct Totals {
+            std::size_t entries{};
+            std::size_t sections{};
+            std::size_t keyBytes{};
+            std::size_t valueBytes{};
+            std::size_t nameBytes{};
+        };
+
+        InitSection  *m_parent{};
+        std::uint64_t m_generation{next_generation()};
+        Totals        m_totals{};
+
+        // only ever set on a root section, see keyIndex(), subscribe() and intern()
+        mutable std::unique_ptr<InitQuery::KeyIndex> m_keyIndex;
+        std::unique_ptr<InitSubscriptions>           m_subscriptions;
+        std::unique_ptr<InitNamePool>                m_names;
+
+        static std::uint64_t next_generation() noexcept;
+
+        /// re-points the parent of every direct entry and subsection at `this`
+        /// needed after the maps have been copied or moved in from another section
+        void adopt_children() noexcept;
+
+        [[nodiscard]] InitSection *root() const noexcept;
+
+        /// the shared name for `text` from the name pool of the tree this section belongs to
+        [[nodiscard]] InitName intern(std::string_view text);
+
+        /// replaces every name in this section and beneath it with the one `pool` holds for the same
+        /// text, adding the names the pool does not have yet. Needed after contents from another tree
+        /// have been moved in; a name that is not shared is still correct, it just costs more
+        void shareNames(InitNamePool& pool);
+
+        /// the key index of the tree this section belongs to, built on first use
+        [[nodiscard]] InitQuery::KeyIndex const& keyIndex() const;
+
+        void indexInto(InitQuery::KeyIndex& index) const;
+
+        void unindexFrom(InitQuery::KeyIndex& index) const noexcept;
+
+        /// what this section contributes to the totals of its parent
+        [[nodiscard]] Totals asChild() const noexcept;
+
+        /// marks this section and all of its ancestors as modified, adding `added` to and
+        /// subtracting `removed` from the totals of each of them on the way up. Returns the root
+        InitSection *touch(Totals const& added, Totals const& removed) noexcept;
+
+        /// tells the subscribers of the tree rooted at `root` about a change to this section, or to
+        /// the entry `key` in it. Costs nothing beyond a null check when there are no subscribers
+        void notify(InitSection const *root, InitChange::Type type, std::string const *key) const;
+
+        /// brings this section in line with `other`, changing only the entries and sections that differ
+        void mergeFrom(InitSection const& other);
 
         static std::vector<std::string> path_to_components(std::string const& path);
 
@@ -43,10 +110,8 @@ namespace Init {
                 if (name == *start) {
                     return std::make_pair(ResolutionType::SECTION, this);
                 }
-                for (auto& [name, entry]: entries) {
-                    if (name == *start) {
-                        return std::make_pair(ResolutionType::ENTRY, &entry);
-                    }
+                if (auto const found = entries.find(std::string_view{*start}); found != entries.end()) {
+                    return std::make_pair(ResolutionType::ENTRY, &found->second);
                 }
                 return std::make_pair(ResolutionType::NONE, nullptr);
             }
@@ -67,15 +132,95 @@ namespace Init {
 
         [[nodiscard]] bool isDefaultNamed() const;
 
+        [[nodiscard]] InitSection *findSubsection(std::string const& name) noexcept;
+
+        [[nodiscard]] InitEntry *findEntry(std::string const& key) noexcept;
+
+        void setEntryValue(InitEntry& entry, std::string const& value);
+
+        /// adds or replaces an entry without looking at its references, for building a tree whose
+        /// references may point at entries that are still to come
+        InitEntry& insertEntry(InitEntry&& entry);
+
+        /// makes `change`, which gives the entry it returns a value with references in it, and then
+        /// expands that entry. If the expansion throws, `undo` reverts the change before the
+        /// exception is passed on and subscribers hear about neither
+        void changeReferences(std::function<InitEntry const&()> const& change, std::function<void()> const& undo);
+
+        /// appends every entry of `section` and its subsections to `out`, each section's own entries
+        /// first and then those of its subsections, so the order only changes when the tree does
+        template <class Entry, class Section>
+        static void collect_entries(Section& section, std::vector<Entry *>& out) {
+            for (auto& [key, entry]: section.entries) {
+                out.push_back(&entry);
+            }
+            for (auto& [name, subsection]: section.subsections) {
+                collect_entries(subsection, out);
+            }
+        }
+
+        /// the values a mutating parallel_visit hands out, as they were before: only their sizes
+        /// unless someone is subscribed to the tree and needs to hear which of them changed
+        struct VisitSnapshot {
+            std::vector<std::size_t> sizes;
+            std::vector<std::string> values;
+        };
+
+        [[nodiscard]] VisitSnapshot snapshot(std::vector<InitEntry *> const& visited) const;
+
+        /// does the bookkeeping that the callbacks of a mutating parallel_visit could not do safely
+        /// from many threads: totals, generations, interpolation and notifications
+        void reconcile(std::vector<InitEntry *> const& visited, VisitSnapshot const& before);
+
     public:
+        friend class InitEntry;
         friend class InitFile;
+        friend class InitOverlay;
+        friend class InitQuery;
+        friend class InitTransaction;
+        friend class InitSharedPublisher;
+        friend class InitSharedView;
+        friend class InitLookupCache;
+        friend class JsonWriter;
+        friend class BinaryWriter;
+        template <class Source>
+        friend class JsonReader;
+        template <class Source>
+        friend class BinaryReader;
 
         using InitSectionName = std::string;
 
         InitSection();
 
-        explicit InitSection(std::string name) noexcept;
+        explicit InitSection(std::string name);
+
+        explicit InitSection(InitName name) noexcept;
+
+        InitSection(InitSection const& other);
+
+        InitSection(InitSection&& other) noexcept;
+
+        InitSection& operator=(InitSection const& other);
 
+        /// takes over the contents of `other` without telling subscribers of either tree; see
+        /// InitFile::reload for replacing contents and announcing what changed. When both are roots
+        /// the subscriptions and name pool of `other` come along, as with the move constructor
+        InitSection& operator=(InitSection&& other) noexcept;
+
+        [[nodiscard]] InitSection *parent() const;
+
+        /// the names of the sections leading from the root to this section
+        [[nodiscard]] std::vector<InitSectionName> path() const;
+
+        /// returns a value that changes whenever this section or anything beneath it is modified
+        /// through the InitSection API or `InitEntry::value()`. Values are never reused, so a section
+        /// that is replaced wholesale (e.g. by re-parsing into the same InitFile) also reports a new
+        /// generation
+        [[nodiscard]] std::uint64_t generation() const noexcept;
+
+        /// `createEntry`, `addEntry`, `updateEntry` and `updateEntryExact` expand a new value that
+        /// contains `${` straight away. If one of its references does not resolve or loops back to
+        /// it they throw MissingEntry or InterpolationCycle and leave the tree as it was
         void createEntry(std::string const& key, std::string const& value);
 
         void addEntry(InitEntry const& entry);
@@ -101,6 +246,18 @@ namespace Init {
 
         InitEntry& getEntryExact(std::vector<std::string> const& path);
 
+        /// equivalent to `getEntryExact(path).interpolated()`. `parse` and the entry mutators check
+        /// references up front, so this only throws InterpolationCycle or MissingEntry after a
+        /// reference was broken some other way, e.g. by removing the entry it names
+        [[nodiscard]] std::string const& getEntryInterpolated(std::string const& path) const;
+
+        [[nodiscard]] std::string const& getEntryInterpolated(std::vector<std::string> const& path) const;
+
+        /// interpolates every entry in this section and its subsections so that reference cycles and
+        /// unresolved references are reported up front rather than on first use. Throws
+        /// InterpolationCycle or MissingEntry for the first problem found
+        void verifyInterpolation() const;
+
         [[nodiscard]] InitSection const& getSectionExact(std::string const& path) const;
 
         InitSection& getSectionExact(std::string const& path);
@@ -123,6 +280,32 @@ namespace Init {
 
         [[nodiscard]] std::optional<std::string> getEntry(std::string const& key) const;
 
+        /// returns the entries whose path relative to this section matches `pattern`. The pattern uses
+        /// the path syntax described above where a component may also be `*`, matching any one
+        /// section name or key, or `**`, matching any number of nested sections (including none).
+        /// For example `routes/*/file` or `**/auth`
+        [[nodiscard]] InitQuery query(std::string const& pattern) const;
+
+        /// returns the entries in this section and all of its subsections whose key starts with `prefix`
+        [[nodiscard]] InitQuery queryKeyPrefix(std::string const& prefix) const;
+
+        using SubscriptionId = InitSubscriptions::Id;
+
+        /// calls `callback` after the entry or section at `path`, relative to this section, is added,
+        /// updated or removed through the InitSection API. Changes made by an InitTransaction commit or
+        /// an InitFile reload are delivered together in a single call once the batch is complete
+        SubscriptionId subscribe(std::string const& path, InitSubscriptions::Callback callback);
+
+        SubscriptionId subscribe(std::vector<std::string> const& path, InitSubscriptions::Callback callback);
+
+        /// like subscribe() but `callback` is also called for changes anywhere beneath `path`
+        SubscriptionId subscribeSubtree(std::string const& path, InitSubscriptions::Callback callback);
+
+        SubscriptionId subscribeSubtree(std::vector<std::string> const& path, InitSubscriptions::Callback callback);
+
+        /// returns false if `id` is not subscribed to this tree
+        bool unsubscribe(SubscriptionId id);
+
         [[nodiscard]] std::vector<InitEntry> getAllEntries() const;
 
         [[nodiscard]] std::vector<InitEntry> getAllEntriesRecursive() const;
@@ -138,8 +321,26 @@ namespace Init {
 
         [[nodiscard]] std::size_t size() const noexcept;
 
+        /// number of entries in this section and all of its subsections
         [[nodiscard]] std::size_t sizeRecursive() const noexcept;
 
+        /// number of sections nested anywhere beneath this one
+        [[nodiscard]] std::size_t subsectionCountRecursive() const noexcept;
+
+        /// total length of every key beneath this section
+        [[nodiscard]] std::size_t keyBytesRecursive() const noexcept;
+
+        /// total length of every value beneath this section
+        [[nodiscard]] std::size_t valueBytesRecursive() const noexcept;
+
+        /// estimated number of bytes used by this section and everything beneath it: the section
+        /// and entry objects, the map keys and the characters of every name, key and value.
+        /// Allocator overhead and unused string capacity are not included
+        [[nodiscard]] std::size_t memoryFootprint() const noexcept;
+
+        /// number of distinct section names and keys stored for the tree this section belongs to
+        [[nodiscard]] std::size_t internedNames() const noexcept;
+
         [[nodiscard]] InitSection const& getSubsection(std::string const& key) const;
 
         [[nodiscard]] InitSection& getSubsection(std::string const& key);
@@ -163,6 +364,80 @@ namespace Init {
             }
         }
 
+        /// calls `l` once for every entry in this section and its subsections, splitting the entries
+        /// into work items of equal size that run on several threads (see ParallelOptions). Every
+        /// entry is handed to exactly one call, so `l` may change the value of the entry it is given
+        /// through `InitEntry::value()`; it must not read entries that other calls may be changing or
+        /// modify the tree in any other way. Once every call has returned the changes are accounted
+        /// for as if each had gone through the InitSection API and subscribers are told about them in
+        /// a single batch. `interpolated()` may only be called from `l` when nothing is being changed
+        /// and verifyInterpolation() has already succeeded. An exception thrown by `l` stops the
+        /// remaining work items from starting and is rethrown, keeping the changes already made
+        template <typename Callable> requires std::is_invocable_v<Callable&, InitEntry&>
+        void parallel_visit(Callable l, ParallelOptions const& options = {}) {
+            std::vector<InitEntry *> visited{};
+            visited.reserve(sizeRecursive());
+            collect_entries(*this, visited);
+            auto const before = snapshot(visited);
+            try {
+                Parallel::run(visited.size(), options, [&](std::size_t, std::size_t begin, std::size_t end) {
+                    InitEntry::DeferredWrites const deferred{};
+                    for (auto i = begin; i < end; i++) {
+                        l(*visited[i]);
+                    }
+                });
+            } catch (...) {
+                reconcile(visited, before);
+                throw;
+            }
+            reconcile(visited, before);
+        }
+
+        /// like parallel_visit but `l` only reads the entries, so nothing needs accounting for
+        /// afterwards. The same restrictions on `interpolated()` apply
+        template <typename Callable> requires std::is_invocable_v<Callable&, InitEntry const&>
+        void parallel_for_each(Callable l, ParallelOptions const& options = {}) const {
+            std::vector<InitEntry const *> visited{};
+            visited.reserve(sizeRecursive());
+            collect_entries(*this, visited);
+            Parallel::run(visited.size(), options, [&](std::size_t, std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    l(*visited[i]);
+                }
+            });
+        }
+
+        /// maps every entry in this section and its subsections to a T on several threads and folds
+        /// the results together with `combine`, starting from `identity`. Each work item is folded
+        /// in entry order and the work items are then combined in order, so as long as `combine` is
+        /// associative the result depends only on the tree and `options.grain`: never on the number
+        /// of threads or how the work happened to be scheduled. The same restrictions on `map` apply
+        /// as to parallel_for_each
+        template <typename T, typename Map, typename Combine>
+            requires std::is_invocable_r_v<T, Map&, InitEntry const&> && std::is_invocable_r_v<T, Combine&, T, T>
+        [[nodiscard]] T parallel_reduce(
+            T                      identity,
+            Map                    map,
+            Combine                combine,
+            ParallelOptions const& options = {}
+        ) const {
+            std::vector<InitEntry const *> visited{};
+            visited.reserve(sizeRecursive());
+            collect_entries(*this, visited);
+            std::vector<std::optional<T> > partial(Parallel::chunks(visited.size(), options));
+            Parallel::run(visited.size(), options, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                T result = identity;
+                for (auto i = begin; i < end; i++) {
+                    result = combine(std::move(result), map(*visited[i]));
+                }
+                partial[chunk].emplace(std::move(result));
+            });
+            for (auto& result: partial) {
+                identity = combine(std::move(identity), std::move(*result));
+            }
+            return identity;
+        }
+
         void print(std::ostream& os = std::cout, int level = 1) const;
     };
 } // namespace Init
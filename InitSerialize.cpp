@@ -0,0 +1,596 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitSerialize.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include "InitException.h"
+
+namespace Init {
+    namespace Util {
+        struct StreamSink {
+            std::ostream& os;
+
+            void put(char c) {
+                os.put(c);
+            }
+
+            void write(std::string_view s) {
+                os.write(s.data(), static_cast<std::streamsize>(s.size()));
+            }
+        };
+
+        /// counts everything written but only keeps what fits, like snprintf
+        struct BufferSink {
+            std::span<char> buffer;
+            std::size_t     size{};
+
+            void put(char c) {
+                if (size < buffer.size()) {
+                    buffer[size] = c;
+                }
+                size++;
+            }
+
+            void write(std::string_view s) {
+                if (size < buffer.size()) {
+                    std::memcpy(buffer.data() + size, s.data(), std::min(s.size(), buffer.size() - size));
+                }
+                size += s.size();
+            }
+        };
+
+        struct BufferSource {
+            std::string_view data;
+            std::size_t      at{};
+
+            int peek() const {
+                return at < data.size() ? static_cast<unsigned char>(data[at]) : EOF;
+            }
+
+            int get() {
+                return at < data.size() ? static_cast<unsigned char>(data[at++]) : EOF;
+            }
+
+            bool read(std::string& out, std::size_t n) {
+                if (n > data.size() - at) {
+                    return false;
+                }
+                out.assign(data.substr(at, n));
+                at += n;
+                return true;
+            }
+
+            [[nodiscard]] std::size_t offset() const {
+                return at;
+            }
+        };
+
+        struct StreamSource {
+            std::istream& is;
+            std::size_t   at{};
+
+            int peek() const {
+                return is.peek();
+            }
+
+            int get() {
+                int const c = is.get();
+                if (c != EOF) {
+                    at++;
+                }
+                return c;
+            }
+
+            bool read(std::string& out, std::size_t n) {
+                // grow as the data arrives rather than trusting a length read from the input
+                out.clear();
+                std::array<char, 4096> chunk{};
+                while (out.size() < n) {
+                    auto const want = std::min(chunk.size(), n - out.size());
+                    is.read(chunk.data(), static_cast<std::streamsize>(want));
+                    auto const got = static_cast<std::size_t>(is.gcount());
+                    out.append(chunk.data(), got);
+                    at += got;
+                    if (got < want) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            [[nodiscard]] std::size_t offset() const {
+                return at;
+            }
+        };
+
+        /// nesting deeper than this in the input is rejected instead of recursing without bound
+        constexpr int MAX_DEPTH = 512;
+    } // namespace Util
+
+    class JsonWriter {
+    public:
+        template <class Sink>
+        static void string(Sink& out, std::string_view s) {
+            static constexpr char HEX[] = "0123456789abcdef";
+            out.put('"');
+            std::size_t start = 0;
+            for (std::size_t i = 0; i < s.size(); i++) {
+                auto const c = static_cast<unsigned char>(s[i]);
+                if (c >= 0x20 && c != '"' && c != '\\') {
+                    continue;
+                }
+                out.write(s.substr(start, i - start));
+                start = i + 1;
+                switch (c) {
+                    case '"':
+                        out.write("\\\"");
+                        break;
+                    case '\\':
+                        out.write("\\\\");
+                        break;
+                    case '\n':
+                        out.write("\\n");
+                        break;
+                    case '\r':
+                        out.write("\\r");
+                        break;
+                    case '\t':
+                        out.write("\\t");
+                        break;
+                    default:
+                        out.write("\\u00");
+                        out.put(HEX[c >> 4]);
+                        out.put(HEX[c & 0xf]);
+                        break;
+                }
+            }
+            out.write(s.substr(start));
+            out.put('"');
+        }
+
+        template <class Sink>
+        static void section(Sink& out, InitSection const& section) {
+            out.put('{');
+            bool first = true;
+            for (auto const& [key, entry]: section.entries) {
+                if (!first) {
+                    out.put(',');
+                }
+                first = false;
+                string(out, key);
+                out.put(':');
+                string(out, entry.value());
+            }
+            for (auto const& [name, subsection]: section.subsections) {
+                if (!first) {
+                    out.put(',');
+                }
+                first = false;
+                string(out, name);
+                out.put(':');
+                JsonWriter::section(out, subsection);
+            }
+            out.put('}');
+        }
+    };
+
+    template <class Source>
+    class JsonReader {
+        Source& in;
+
+        [[noreturn]] void fail(std::string const& what) const {
+            throw ParseException("InitJson::read: " + what + " at offset " + std::to_string(in.offset()));
+        }
+
+        void skipWhitespace() {
+            for (int c = in.peek(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = in.peek()) {
+                in.get();
+            }
+        }
+
+        void expect(char c) {
+            if (in.get() != c) {
+                fail(std::string{"expected '"} + c + "'");
+            }
+        }
+
+        unsigned hex4() {
+            unsigned value = 0;
+            for (int i = 0; i < 4; i++) {
+                int const c = in.get();
+                value <<= 4;
+                if (c >= '0' && c <= '9') {
+                    value |= c - '0';
+                } else if (c >= 'a' && c <= 'f') {
+                    value |= c - 'a' + 10;
+                } else if (c >= 'A' && c <= 'F') {
+                    value |= c - 'A' + 10;
+                } else {
+                    fail("invalid \\u escape");
+                }
+            }
+            return value;
+        }
+
+        static void appendUtf8(std::string& out, unsigned cp) {
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+            } else if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xc0 | cp >> 6));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            } else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xe0 | cp >> 12));
+                out.push_back(static_cast<char>(0x80 | (cp >> 6 & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            } else {
+                out.push_back(static_cast<char>(0xf0 | cp >> 18));
+                out.push_back(static_cast<char>(0x80 | (cp >> 12 & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (cp >> 6 & 0x3f)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+            }
+        }
+
+        std::string string() {
+            expect('"');
+            std::string out{};
+            while (true) {
+                int const c = in.get();
+                if (c == EOF) {
+                    fail("unterminated string");
+                }
+                if (c == '"') {
+                    return out;
+                }
+                if (c < 0x20) {
+                    fail("control character in string");
+                }
+                if (c != '\\') {
+                    out.push_back(static_cast<char>(c));
+                    continue;
+                }
+                switch (in.get()) {
+                    case '"':
+                        out.push_back('"');
+                        break;
+                    case '\\':
+                        out.push_back('\\');
+                        break;
+                    case '/':
+                        out.push_back('/');
+                        break;
+                    case 'b':
+                        out.push_back('\b');
+                        break;
+                    case 'f':
+                        out.push_back('\f');
+                        break;
+                    case 'n':
+                        out.push_back('\n');
+                        break;
+                    case 'r':
+                        out.push_back('\r');
+                        break;
+                    case 't':
+                        out.push_back('\t');
+                        break;
+                    case 'u': {
+                        unsigned cp = hex4();
+                        if (cp >= 0xd800 && cp < 0xdc00) {
+                            // a high surrogate must be followed by the low half of the pair
+                            expect('\\');
+                            expect('u');
+                            unsigned const low = hex4();
+                            if (low < 0xdc00 || low >= 0xe000) {
+                                fail("invalid surrogate pair");
+                            }
+                            cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                        } else if (cp >= 0xdc00 && cp < 0xe000) {
+                            fail("invalid surrogate pair");
+                        }
+                        appendUtf8(out, cp);
+                        break;
+                    }
+                    default:
+                        fail("invalid escape");
+                }
+            }
+        }
+
+        /// a number, true or false, kept as written
+        std::string literal() {
+            std::string out{};
+            for (int c = in.peek(); c != EOF && (std::isalnum(c) || c == '-' || c == '+' || c == '.'); c = in.peek()) {
+                out.push_back(static_cast<char>(in.get()));
+            }
+            if (out == "true" || out == "false") {
+                return out;
+            }
+            char *end = nullptr;
+            std::strtod(out.c_str(), &end);
+            if (out.empty() || end != out.c_str() + out.size() || !(out[0] == '-' || std::isdigit(out[0]))) {
+                fail("expected a string, number, boolean or object");
+            }
+            return out;
+        }
+
+    public:
+        explicit JsonReader(Source& in) : in(in) {}
+
+        void object(InitSection& section, int depth) {
+            if (depth > Util::MAX_DEPTH) {
+                fail("objects nested too deeply");
+            }
+            skipWhitespace();
+            expect('{');
+            skipWhitespace();
+            if (in.peek() == '}') {
+                in.get();
+                return;
+            }
+            while (true) {
+                skipWhitespace();
+                auto key = string();
+                skipWhitespace();
+                expect(':');
+                skipWhitespace();
+                switch (in.peek()) {
+                    case '{':
+                        object(section.createSubsection(key), depth + 1);
+                        break;
+                    case '"':
+                        section.insertEntry(InitEntry{std::move(key), string()});
+                        break;
+                    default:
+                        section.insertEntry(InitEntry{std::move(key), literal()});
+                        break;
+                }
+                skipWhitespace();
+                int const c = in.get();
+                if (c == '}') {
+                    return;
+                }
+                if (c != ',') {
+                    fail("expected ',' or '}'");
+                }
+            }
+        }
+
+        void end() {
+            skipWhitespace();
+            if (in.peek() != EOF) {
+                fail("unexpected text after the object");
+            }
+        }
+    };
+
+    class BinaryWriter {
+        static constexpr char MAGIC[4] = {'I', 'N', 'I', 'B'};
+        static constexpr char VERSION  = 1;
+
+        static std::size_t varintSize(std::uint64_t v) {
+            std::size_t n = 1;
+            for (; v >= 0x80; v >>= 7) {
+                n++;
+            }
+            return n;
+        }
+
+        template <class Sink>
+        static void varint(Sink& out, std::uint64_t v) {
+            for (; v >= 0x80; v >>= 7) {
+                out.put(static_cast<char>((v & 0x7f) | 0x80));
+            }
+            out.put(static_cast<char>(v));
+        }
+
+        template <class Sink>
+        static void string(Sink& out, std::string_view s) {
+            varint(out, s.size());
+            out.write(s);
+        }
+
+        static std::size_t stringSize(std::string_view s) {
+            return varintSize(s.size()) + s.size();
+        }
+
+    public:
+        static constexpr std::size_t HEADER_SIZE = sizeof(MAGIC) + 1 + 8;
+
+        static std::size_t bodySize(InitSection const& section) {
+            auto n = varintSize(section.entries.size()) + varintSize(section.subsections.size());
+            for (auto const& [key, entry]: section.entries) {
+                n += stringSize(key) + stringSize(entry.value());
+            }
+            for (auto const& [name, subsection]: section.subsections) {
+                n += stringSize(name) + bodySize(subsection);
+            }
+            return n;
+        }
+
+        template <class Sink>
+        static void body(Sink& out, InitSection const& section) {
+            varint(out, section.entries.size());
+            for (auto const& [key, entry]: section.entries) {
+                string(out, key);
+                string(out, entry.value());
+            }
+            varint(out, section.subsections.size());
+            for (auto const& [name, subsection]: section.subsections) {
+                string(out, name);
+                body(out, subsection);
+            }
+        }
+
+        template <class Sink>
+        static void message(Sink& out, InitSection const& section) {
+            out.write({MAGIC, sizeof(MAGIC)});
+            out.put(VERSION);
+            auto length = static_cast<std::uint64_t>(bodySize(section));
+            for (int i = 0; i < 8; i++, length >>= 8) {
+                out.put(static_cast<char>(length & 0xff));
+            }
+            body(out, section);
+        }
+
+        static bool validHeader(std::string_view header) {
+            return header.size() == HEADER_SIZE
+                   && header.substr(0, sizeof(MAGIC)) == std::string_view{MAGIC, sizeof(MAGIC)}
+                   && header[sizeof(MAGIC)] == VERSION;
+        }
+    };
+
+    template <class Source>
+    class BinaryReader {
+        Source& in;
+
+        [[noreturn]] void fail(std::string const& what) const {
+            throw ParseException("InitBinary::read: " + what + " at offset " + std::to_string(in.offset()));
+        }
+
+        std::uint64_t varint() {
+            std::uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                int const c = in.get();
+                if (c == EOF) {
+                    fail("truncated message");
+                }
+                v |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+                if ((c & 0x80) == 0) {
+                    return v;
+                }
+            }
+            fail("invalid varint");
+        }
+
+        std::string string() {
+            std::string out{};
+            if (!in.read(out, varint())) {
+                fail("truncated message");
+            }
+            return out;
+        }
+
+    public:
+        explicit BinaryReader(Source& in) : in(in) {}
+
+        /// reads the header and returns the length of the body
+        std::uint64_t header() {
+            std::string header{};
+            if (!in.read(header, BinaryWriter::HEADER_SIZE) || !BinaryWriter::validHeader(header)) {
+                fail("not an InitBinary message");
+            }
+            std::uint64_t length = 0;
+            for (int i = 7; i >= 0; i--) {
+                length = length << 8 | static_cast<unsigned char>(header[BinaryWriter::HEADER_SIZE - 8 + i]);
+            }
+            return length;
+        }
+
+        void body(InitSection& section, int depth) {
+            if (depth > Util::MAX_DEPTH) {
+                fail("sections nested too deeply");
+            }
+            for (auto entries = varint(); entries > 0; entries--) {
+                auto key = string();
+                section.insertEntry(InitEntry{std::move(key), string()});
+            }
+            for (auto sections = varint(); sections > 0; sections--) {
+                body(section.createSubsection(string()), depth + 1);
+            }
+        }
+
+        void end(std::uint64_t start, std::uint64_t length) {
+            if (in.offset() - start != length) {
+                fail("message length does not match its contents");
+            }
+        }
+    };
+
+    void InitJson::write(InitSection const& section, std::ostream& os) {
+        Util::StreamSink out{os};
+        JsonWriter::section(out, section);
+    }
+
+    std::size_t InitJson::write(InitSection const& section, std::span<char> buffer) {
+        Util::BufferSink out{buffer};
+        JsonWriter::section(out, section);
+        return out.size;
+    }
+
+    std::string InitJson::write(InitSection const& section) {
+        std::ostringstream os{};
+        write(section, os);
+        return std::move(os).str();
+    }
+
+    InitSection InitJson::read(std::istream& is, std::string name) {
+        InitSection        section{std::move(name)};
+        Util::StreamSource in{is};
+        JsonReader{in}.object(section, 0);
+        return section;
+    }
+
+    InitSection InitJson::read(std::string_view json, std::string name) {
+        InitSection        section{std::move(name)};
+        Util::BufferSource in{json};
+        JsonReader         reader{in};
+        reader.object(section, 0);
+        reader.end();
+        return section;
+    }
+
+    std::size_t InitBinary::encodedSize(InitSection const& section) {
+        return BinaryWriter::HEADER_SIZE + BinaryWriter::bodySize(section);
+    }
+
+    void InitBinary::write(InitSection const& section, std::ostream& os) {
+        Util::StreamSink out{os};
+        BinaryWriter::message(out, section);
+    }
+
+    std::size_t InitBinary::write(InitSection const& section, std::span<char> buffer) {
+        Util::BufferSink out{buffer};
+        BinaryWriter::message(out, section);
+        return out.size;
+    }
+
+    std::string InitBinary::write(InitSection const& section) {
+        std::string message(encodedSize(section), '\0');
+        write(section, std::span{message});
+        return message;
+    }
+
+    InitSection InitBinary::read(std::istream& is, std::string name) {
+        InitSection        section{std::move(name)};
+        Util::StreamSource in{is};
+        BinaryReader       reader{in};
+        auto const         length = reader.header();
+        auto const         start  = in.offset();
+        reader.body(section, 0);
+        reader.end(start, length);
+        return section;
+    }
+
+    InitSection InitBinary::read(std::string_view message, std::string name) {
+        InitSection        section{std::move(name)};
+        Util::BufferSource in{message};
+        BinaryReader       reader{in};
+        auto const         length = reader.header();
+        if (length != message.size() - in.offset()) {
+            throw ParseException("InitBinary::read: message length does not match the buffer");
+        }
+        auto const start = in.offset();
+        reader.body(section, 0);
+        reader.end(start, length);
+        return section;
+    }
+} // namespace Init
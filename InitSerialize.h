@@ -0,0 +1,72 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITSERIALIZE_H
+#define INITSERIALIZE_H
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "InitSection.h"
+
+namespace Init {
+    /// Writes a section tree as JSON and reads it back, streaming straight between the tree and the
+    /// output or input without building any intermediate document.
+    ///
+    /// A section is an object in which each entry is a string member and each subsection an object
+    /// member. An entry and a subsection of the same section may share a name, in which case both
+    /// members are written and told apart by their type when read. The name of the section being
+    /// written is not part of the output. Reading also accepts numbers, true and false as entry
+    /// values, kept as the text they were written with. Problems in the input throw ParseException
+    class InitJson {
+    public:
+        static void write(InitSection const& section, std::ostream& os);
+
+        /// writes as much of the JSON as fits into `buffer` and returns the size of all of it, so a
+        /// result larger than `buffer.size()` means the output was cut short
+        static std::size_t write(InitSection const& section, std::span<char> buffer);
+
+        [[nodiscard]] static std::string write(InitSection const& section);
+
+        /// reads one JSON object from `is`, leaving anything after it unread
+        [[nodiscard]] static InitSection read(std::istream& is, std::string name = InitSection::DEFAULT_NAME);
+
+        /// reads `json`, which must hold a single object and nothing but whitespace after it
+        [[nodiscard]] static InitSection read(std::string_view json, std::string name = InitSection::DEFAULT_NAME);
+    };
+
+    /// Writes a section tree in a compact binary encoding and reads it back, streaming straight
+    /// between the tree and the output or input.
+    ///
+    /// A message is the four bytes "INIB", a format version byte and the length of the rest of the
+    /// message as 8 little endian bytes, so messages can be framed back to back in a stream. The rest
+    /// is the section: the number of entries followed by the key and value of each, then the number
+    /// of subsections followed by the name and contents of each. Every count and string length is an
+    /// unsigned LEB128 varint. The name of the section being written is not part of the message.
+    /// Malformed or truncated messages throw ParseException
+    class InitBinary {
+    public:
+        /// the size of the message `write` produces for `section`
+        [[nodiscard]] static std::size_t encodedSize(InitSection const& section);
+
+        static void write(InitSection const& section, std::ostream& os);
+
+        /// writes as much of the message as fits into `buffer` and returns the size of all of it, so
+        /// a result larger than `buffer.size()` means the output was cut short
+        static std::size_t write(InitSection const& section, std::span<char> buffer);
+
+        [[nodiscard]] static std::string write(InitSection const& section);
+
+        /// reads one message from `is`, leaving anything after it unread
+        [[nodiscard]] static InitSection read(std::istream& is, std::string name = InitSection::DEFAULT_NAME);
+
+        /// reads `message`, which must hold exactly one message
+        [[nodiscard]] static InitSection read(std::string_view message, std::string name = InitSection::DEFAULT_NAME);
+    };
+} // namespace Init
+
+#endif // INITSERIALIZE_H
@@ -0,0 +1,484 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitShared.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "InitException.h"
+
+namespace Init {
+    namespace Shared {
+        constexpr char MAGIC[8] = {'I', 'N', 'I', 'T', 'S', 'H', 'M', '1'};
+
+        static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared memory needs lock free atomics");
+
+        /// the start of the segment. Buffer `version & 1` holds the current tree. Each buffer has its own
+        /// sequence number which is odd while the publisher is writing it, so a reader can tell that
+        /// the buffer it was reading changed underneath it and retry
+        struct alignas(64) SegmentHeader {
+            char                       magic[8];
+            std::uint64_t              capacity;
+            std::atomic<std::uint64_t> version;
+            std::atomic<std::uint64_t> sequence[2];
+        };
+
+        // a buffer is a FlatHeader, then every section, then every entry, then the characters of all
+        // names, keys and values. Sections are stored breadth first so the children of a section are
+        // contiguous and always come after it; children and entries are sorted by name
+        struct FlatHeader {
+            std::uint32_t sectionCount;
+            std::uint32_t entryCount;
+            std::uint64_t characterCount;
+        };
+
+        struct FlatSection {
+            std::uint32_t nameOffset;
+            std::uint32_t nameLength;
+            std::uint32_t firstEntry;
+            std::uint32_t entryCount;
+            std::uint32_t firstChild;
+            std::uint32_t childCount;
+        };
+
+        struct FlatEntry {
+            std::uint32_t keyOffset;
+            std::uint32_t keyLength;
+            std::uint32_t valueOffset;
+            std::uint32_t valueLength;
+        };
+
+        static std::size_t round_up(std::size_t n) {
+            return (n + 7) & ~std::size_t{7};
+        }
+
+        static std::byte *buffer(SegmentHeader *header, std::size_t i) {
+            return reinterpret_cast<std::byte *>(header) + sizeof(SegmentHeader) + i * header->capacity;
+        }
+
+        static std::byte const *buffer(SegmentHeader const *header, std::size_t i) {
+            return reinterpret_cast<std::byte const *>(header) + sizeof(SegmentHeader) + i * header->capacity;
+        }
+
+        /// bounds checked access to one buffer. A buffer that is being rewritten can hold anything, so
+        /// every offset is checked before use; the result of such a read is thrown away by the caller
+        struct BufferView {
+            FlatHeader         header{};
+            FlatSection const *sections{};
+            FlatEntry const   *entries{};
+            char const        *characters{};
+
+            BufferView() = default;
+
+            BufferView(std::byte const *data, std::size_t capacity) {
+                std::memcpy(&header, data, sizeof(FlatHeader));
+                auto const needed = sizeof(FlatHeader) + std::size_t{header.sectionCount} * sizeof(FlatSection)
+                                    + std::size_t{header.entryCount} * sizeof(FlatEntry) + header.characterCount;
+                if (needed > capacity) {
+                    header = {};
+                    return;
+                }
+                sections   = reinterpret_cast<FlatSection const *>(data + sizeof(FlatHeader));
+                entries    = reinterpret_cast<FlatEntry const *>(sections + header.sectionCount);
+                characters = reinterpret_cast<char const *>(entries + header.entryCount);
+            }
+
+            [[nodiscard]] std::string_view text(std::uint32_t offset, std::uint32_t length) const {
+                if (std::uint64_t{offset} + length > header.characterCount) {
+                    return {};
+                }
+                return {characters + offset, length};
+            }
+
+            [[nodiscard]] FlatSection const *section(std::uint32_t i) const {
+                return i < header.sectionCount ? &sections[i] : nullptr;
+            }
+
+            [[nodiscard]] FlatSection const *root() const {
+                return section(0);
+            }
+
+            [[nodiscard]] FlatSection const *child(FlatSection const& s, std::string_view name) const {
+                auto const self = static_cast<std::uint32_t>(&s - sections);
+                if (s.firstChild <= self || std::uint64_t{s.firstChild} + s.childCount > header.sectionCount) {
+                    return nullptr;
+                }
+                auto const *first = sections + s.firstChild;
+                auto const *last  = first + s.childCount;
+                auto const *found = std::lower_bound(first, last, name, [this](FlatSection const& c, std::string_view n) {
+                    return text(c.nameOffset, c.nameLength) < n;
+                });
+                return found != last && text(found->nameOffset, found->nameLength) == name ? found : nullptr;
+            }
+
+            [[nodiscard]] FlatEntry const *entry(FlatSection const& s, std::string_view key) const {
+                if (std::uint64_t{s.firstEntry} + s.entryCount > header.entryCount) {
+                    return nullptr;
+                }
+                auto const *first = entries + s.firstEntry;
+                auto const *last  = first + s.entryCount;
+                auto const *found = std::lower_bound(first, last, key, [this](FlatEntry const& e, std::string_view k) {
+                    return text(e.keyOffset, e.keyLength) < k;
+                });
+                return found != last && text(found->keyOffset, found->keyLength) == key ? found : nullptr;
+            }
+
+            /// the section holding the last component of `path`, if every other component names a section
+            [[nodiscard]] FlatSection const *parentOf(std::vector<std::string> const& path) const {
+                auto const *s = root();
+                for (std::size_t i = 0; i + 1 < path.size() && s != nullptr; i++) {
+                    s = child(*s, path[i]);
+                }
+                return s;
+            }
+
+            bool pathTo(FlatSection const& s, std::string_view key, std::vector<std::string>& path) const {
+                if (entry(s, key) != nullptr) {
+                    path.emplace_back(key);
+                    return true;
+                }
+                auto const self = static_cast<std::uint32_t>(&s - sections);
+                if (s.firstChild <= self || std::uint64_t{s.firstChild} + s.childCount > header.sectionCount) {
+                    return false;
+                }
+                for (std::uint32_t i = 0; i < s.childCount; i++) {
+                    auto const& c = sections[s.firstChild + i];
+                    if (pathTo(c, key, path)) {
+                        path.emplace_back(text(c.nameOffset, c.nameLength));
+                        return true;
+                    }
+                }
+                return false;
+            }
+        };
+    } // namespace Shared
+
+    std::size_t InitSharedPublisher::requiredCapacity(InitSection const& root) {
+        using namespace Shared;
+        return sizeof(FlatHeader) + (root.subsectionCountRecursive() + 1) * sizeof(FlatSection)
+               + root.sizeRecursive() * sizeof(FlatEntry) + root.name.size() + root.m_totals.nameBytes
+               + root.keyBytesRecursive() + root.valueBytesRecursive();
+    }
+
+    InitSharedPublisher::InitSharedPublisher(std::string name, std::size_t capacity) : name(std::move(name)) {
+        using namespace Shared;
+        capacity = round_up(std::max(capacity, sizeof(FlatHeader)));
+        if (capacity > UINT32_MAX) {
+            throw InitException("InitSharedPublisher: capacity must be less than 4GiB");
+        }
+        mappingSize = sizeof(SegmentHeader) + 2 * capacity;
+
+        ::shm_unlink(this->name.c_str());
+        int const fd = ::shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) {
+            throw InitException("InitSharedPublisher: shm_open failed: " + std::string{std::strerror(errno)});
+        }
+        if (::ftruncate(fd, static_cast<off_t>(mappingSize)) != 0) {
+            auto const error = errno;
+            ::close(fd);
+            ::shm_unlink(this->name.c_str());
+            throw InitException("InitSharedPublisher: ftruncate failed: " + std::string{std::strerror(error)});
+        }
+        void *mapping = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            ::shm_unlink(this->name.c_str());
+            throw InitException("InitSharedPublisher: mmap failed: " + std::string{std::strerror(errno)});
+        }
+
+        header           = new (mapping) SegmentHeader{};
+        header->capacity = capacity;
+        // readers check the magic before anything else, so it goes in last
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    }
+
+    InitSharedPublisher::~InitSharedPublisher() {
+        if (header != nullptr) {
+            ::munmap(header, mappingSize);
+        }
+    }
+
+    void InitSharedPublisher::publish(InitSection const& root) {
+        using namespace Shared;
+        auto const required = requiredCapacity(root);
+        if (required > header->capacity) {
+            throw InitException(
+                "InitSharedPublisher::publish: tree needs " + std::to_string(required) + " bytes but the segment holds "
+                + std::to_string(header->capacity)
+            );
+        }
+
+        auto const next     = header->version.load(std::memory_order_relaxed) + 1;
+        auto const i        = next & 1;
+        auto&      sequence = header->sequence[i];
+        auto const s        = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        auto *const data       = buffer(header, i);
+        auto const  sections   = root.subsectionCountRecursive() + 1;
+        auto const  entryCount = root.sizeRecursive();
+        auto *const flatSections =
+                reinterpret_cast<FlatSection *>(data + sizeof(FlatHeader));
+        auto *const flatEntries = reinterpret_cast<FlatEntry *>(flatSections + sections);
+        auto *const characters  = reinterpret_cast<char *>(flatEntries + entryCount);
+
+        // the totals behind `required` are only as good as the mutators that keep them, so every
+        // write is checked against the room actually left in the buffer as well
+        auto const characterCapacity =
+                header->capacity - static_cast<std::size_t>(characters - reinterpret_cast<char *>(data));
+        std::uint32_t characterCount = 0;
+        auto const    put            = [&](std::string const& s) {
+            if (s.size() > characterCapacity - characterCount) {
+                throw InitException(
+                    "InitSharedPublisher::publish: tree does not fit in the " + std::to_string(header->capacity)
+                    + " bytes of the segment"
+                );
+            }
+            std::memcpy(characters + characterCount, s.data(), s.size());
+            auto const offset = characterCount;
+            characterCount += static_cast<std::uint32_t>(s.size());
+            return offset;
+        };
+
+        try {
+            // breadth first so that children are contiguous
+            std::vector<InitSection const *>                                order{&root};
+            std::vector<std::pair<std::string const *, InitSection const *> > children{};
+            std::vector<std::pair<std::string const *, InitEntry const *> >   entries{};
+            std::uint32_t                                                     nextEntry = 0;
+            for (std::size_t at = 0; at < order.size(); at++) {
+                auto const& section = *order[at];
+                auto&       flat    = flatSections[at];
+                flat.nameLength     = static_cast<std::uint32_t>(section.name.size());
+                flat.nameOffset     = put(section.name);
+
+                entries.clear();
+                for (auto const& [key, entry]: section.entries) {
+                    entries.emplace_back(&key.str(), &entry);
+                }
+                std::ranges::sort(entries, {}, [](auto const& e) -> std::string const& { return *e.first; });
+                flat.firstEntry = nextEntry;
+                flat.entryCount = static_cast<std::uint32_t>(entries.size());
+                for (auto const& [key, entry]: entries) {
+                    auto& e       = flatEntries[nextEntry++];
+                    e.keyLength   = static_cast<std::uint32_t>(key->size());
+                    e.keyOffset   = put(*key);
+                    e.valueLength = static_cast<std::uint32_t>(entry->value().size());
+                    e.valueOffset = put(entry->value());
+                }
+
+                children.clear();
+                for (auto const& [childName, child]: section.subsections) {
+                    children.emplace_back(&childName.str(), &child);
+                }
+                std::ranges::sort(children, {}, [](auto const& c) -> std::string const& { return *c.first; });
+                flat.firstChild = static_cast<std::uint32_t>(order.size());
+                flat.childCount = static_cast<std::uint32_t>(children.size());
+                for (auto const& [childName, child]: children) {
+                    order.push_back(child);
+                }
+            }
+        } catch (...) {
+            // the version still names the other buffer; the even sequence tells anyone who looked at
+            // this one that it changed
+            sequence.store(s + 2, std::memory_order_release);
+            throw;
+        }
+
+        FlatHeader const flatHeader{
+            static_cast<std::uint32_t>(sections),
+            static_cast<std::uint32_t>(entryCount),
+            characterCount
+        };
+        std::memcpy(data, &flatHeader, sizeof(FlatHeader));
+
+        sequence.store(s + 2, std::memory_order_release);
+        header->version.store(next, std::memory_order_release);
+    }
+
+    void InitSharedPublisher::publish(InitFile const& file) {
+        publish(file.sections());
+    }
+
+    std::uint64_t InitSharedPublisher::version() const noexcept {
+        return header->version.load(std::memory_order_acquire);
+    }
+
+    void InitSharedPublisher::remove(std::string const& name) {
+        ::shm_unlink(name.c_str());
+    }
+
+    InitSharedView::InitSharedView(std::string const& name) {
+        using namespace Shared;
+        int const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) {
+            throw InitException("InitSharedView: shm_open failed: " + std::string{std::strerror(errno)});
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(SegmentHeader)) {
+            ::close(fd);
+            throw InitException("InitSharedView: " + name + " is not an InitSharedPublisher segment");
+        }
+        mappingSize   = static_cast<std::size_t>(st.st_size);
+        void *mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw InitException("InitSharedView: mmap failed: " + std::string{std::strerror(errno)});
+        }
+        header = static_cast<SegmentHeader const *>(mapping);
+        if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+            || sizeof(SegmentHeader) + 2 * header->capacity > mappingSize) {
+            ::munmap(mapping, mappingSize);
+            header = nullptr;
+            throw InitException("InitSharedView: " + name + " is not an InitSharedPublisher segment");
+        }
+    }
+
+    InitSharedView::~InitSharedView() {
+        if (header != nullptr) {
+            ::munmap(const_cast<Shared::SegmentHeader *>(header), mappingSize);
+        }
+    }
+
+    template <typename Lookup>
+    auto InitSharedView::read(Lookup lookup) const {
+        using namespace Shared;
+        while (true) {
+            auto const version = header->version.load(std::memory_order_acquire);
+            if (version == 0) {
+                return lookup(BufferView{});
+            }
+            auto const  i        = version & 1;
+            auto const& sequence = header->sequence[i];
+            auto const  s        = sequence.load(std::memory_order_acquire);
+            if ((s & 1) != 0) {
+                // the publisher has lapped this reader and is rewriting the buffer
+                continue;
+            }
+            auto result = lookup(BufferView{buffer(header, i), header->capacity});
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == s) {
+                return result;
+            }
+        }
+    }
+
+    std::uint64_t InitSharedView::version() const noexcept {
+        return header->version.load(std::memory_order_acquire);
+    }
+
+    std::optional<std::string> InitSharedView::getEntry(std::string const& key) const {
+        return read([&key](Shared::BufferView const& view) -> std::optional<std::string> {
+            auto const *root = view.root();
+            auto const *e    = root == nullptr ? nullptr : view.entry(*root, key);
+            if (e == nullptr) {
+                return std::nullopt;
+            }
+            return std::string{view.text(e->valueOffset, e->valueLength)};
+        });
+    }
+
+    bool InitSharedView::hasEntry(std::string const& key) const {
+        return read([&key](Shared::BufferView const& view) {
+            auto const *root = view.root();
+            return root != nullptr && view.entry(*root, key) != nullptr;
+        });
+    }
+
+    InitSection::ResolutionType InitSharedView::canResolve(std::string const& path) const {
+        return canResolve(InitSection::path_to_components(path));
+    }
+
+    InitSection::ResolutionType InitSharedView::canResolve(std::vector<std::string> const& path) const {
+        return read([&path](Shared::BufferView const& view) {
+            auto const *parent = path.empty() ? nullptr : view.parentOf(path);
+            if (parent == nullptr) {
+                return InitSection::ResolutionType::NONE;
+            }
+            if (view.entry(*parent, path.back()) != nullptr) {
+                return InitSection::ResolutionType::ENTRY;
+            }
+            if (view.child(*parent, path.back()) != nullptr) {
+                return InitSection::ResolutionType::SECTION;
+            }
+            return InitSection::ResolutionType::NONE;
+        });
+    }
+
+    bool InitSharedView::hasEntryExact(std::string const& path) const {
+        return canResolve(path) == InitSection::ResolutionType::ENTRY;
+    }
+
+    bool InitSharedView::hasEntryExact(std::vector<std::string> const& path) const {
+        return canResolve(path) == InitSection::ResolutionType::ENTRY;
+    }
+
+    std::string InitSharedView::getEntryExact(std::string const& path) const {
+        return getEntryExact(InitSection::path_to_components(path));
+    }
+
+    std::string InitSharedView::getEntryExact(std::vector<std::string> const& path) const {
+        auto [kind, value] = read([&path](Shared::BufferView const& view) {
+            auto const *parent = path.empty() ? nullptr : view.parentOf(path);
+            if (parent == nullptr) {
+                return std::make_pair(InitSection::ResolutionType::NONE, std::string{});
+            }
+            if (auto const *e = view.entry(*parent, path.back()); e != nullptr) {
+                return std::make_pair(
+                    InitSection::ResolutionType::ENTRY,
+                    std::string{view.text(e->valueOffset, e->valueLength)}
+                );
+            }
+            if (view.child(*parent, path.back()) != nullptr) {
+                return std::make_pair(InitSection::ResolutionType::SECTION, std::string{});
+            }
+            return std::make_pair(InitSection::ResolutionType::NONE, std::string{});
+        });
+        switch (kind) {
+            case InitSection::ResolutionType::NONE:
+                throw MissingEntry("InitSharedView::getEntryExact: no such entry");
+            case InitSection::ResolutionType::SECTION:
+                throw InitException("InitSharedView::getEntryExact: can't get section ");
+            case InitSection::ResolutionType::ENTRY:
+                return value;
+            default:
+                throw std::runtime_error("InitSharedView::getEntryExact: unknown branch");
+        }
+    }
+
+    std::optional<std::vector<std::string> > InitSharedView::getPathToEntry(std::string const& key) const {
+        return read([&key](Shared::BufferView const& view) -> std::optional<std::vector<std::string> > {
+            std::vector<std::string> path{};
+            auto const              *root = view.root();
+            if (root == nullptr || !view.pathTo(*root, key, path)) {
+                return std::nullopt;
+            }
+            std::ranges::reverse(path);
+            return path;
+        });
+    }
+
+    std::size_t InitSharedView::size() const {
+        return read([](Shared::BufferView const& view) -> std::size_t {
+            auto const *root = view.root();
+            return root == nullptr ? 0 : root->entryCount;
+        });
+    }
+
+    std::size_t InitSharedView::sizeRecursive() const {
+        return read([](Shared::BufferView const& view) -> std::size_t { return view.header.entryCount; });
+    }
+} // namespace Init
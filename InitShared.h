@@ -0,0 +1,120 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITSHARED_H
+#define INITSHARED_H
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "InitFile.h"
+#include "InitSection.h"
+
+namespace Init {
+    namespace Shared {
+        struct SegmentHeader;
+        struct BufferView;
+    } // namespace Shared
+
+    /// Publishes a section tree into a POSIX shared memory segment so that any number of processes
+    /// on the host can read it through an InitSharedView without parsing the file themselves.
+    ///
+    /// The segment holds two buffers in a relocatable flat format: every reference is an offset,
+    /// sections and entries are sorted by name so lookups are binary searches. A publish writes the
+    /// buffer readers are not using and then switches them over, so readers never wait on the
+    /// publisher and pick up the new version on their next lookup.
+    ///
+    /// A segment must have a single publisher
+    class InitSharedPublisher {
+        std::string            name;
+        std::size_t            mappingSize{};
+        Shared::SegmentHeader *header{};
+
+    public:
+        /// creates the shared memory segment `name` (e.g. "/my-service-config"), replacing any
+        /// existing segment of that name, with room for a tree of up to `capacity` bytes in the flat format
+        InitSharedPublisher(std::string name, std::size_t capacity);
+
+        InitSharedPublisher(InitSharedPublisher const&) = delete;
+
+        InitSharedPublisher& operator=(InitSharedPublisher const&) = delete;
+
+        /// unmaps the segment. The segment itself stays available to readers until `remove` is called
+        ~InitSharedPublisher();
+
+        /// number of bytes `root` takes up in the flat format
+        [[nodiscard]] static std::size_t requiredCapacity(InitSection const& root);
+
+        /// writes `root` into the segment and makes it the current version.
+        /// Throws InitException if the tree does not fit in the capacity of the segment, in which case
+        /// readers keep seeing the previous version
+        void publish(InitSection const& root);
+
+        void publish(InitFile const& file);
+
+        /// the version most recently published, starting at 1 for the first publish
+        [[nodiscard]] std::uint64_t version() const noexcept;
+
+        /// removes the segment name so no new readers can attach. Existing mappings stay valid
+        static void remove(std::string const& name);
+    };
+
+    /// A read-only view of a tree published by an InitSharedPublisher. Supports the lookups of
+    /// InitSection; paths are resolved exactly from the root, each component but the last naming a
+    /// section and the last naming an entry or, if there is no such entry, a section.
+    /// Results are copied out of the segment because the buffer they came from is reused by the
+    /// publisher two versions later
+    class InitSharedView {
+        std::size_t                  mappingSize{};
+        Shared::SegmentHeader const *header{};
+
+        template <typename Lookup>
+        auto read(Lookup lookup) const;
+
+    public:
+        /// attaches to the segment `name`. Throws InitException if it does not exist or is not
+        /// an InitSharedPublisher segment
+        explicit InitSharedView(std::string const& name);
+
+        InitSharedView(InitSharedView const&) = delete;
+
+        InitSharedView& operator=(InitSharedView const&) = delete;
+
+        ~InitSharedView();
+
+        /// the version that the next lookup will read, 0 if nothing has been published yet
+        [[nodiscard]] std::uint64_t version() const noexcept;
+
+        /// looks up `key` in the default section
+        [[nodiscard]] std::optional<std::string> getEntry(std::string const& key) const;
+
+        [[nodiscard]] bool hasEntry(std::string const& key) const;
+
+        [[nodiscard]] InitSection::ResolutionType canResolve(std::string const& path) const;
+
+        [[nodiscard]] InitSection::ResolutionType canResolve(std::vector<std::string> const& path) const;
+
+        [[nodiscard]] bool hasEntryExact(std::string const& path) const;
+
+        [[nodiscard]] bool hasEntryExact(std::vector<std::string> const& path) const;
+
+        /// returns the value of the entry at `path`, throws MissingEntry if there is none
+        [[nodiscard]] std::string getEntryExact(std::string const& path) const;
+
+        [[nodiscard]] std::string getEntryExact(std::vector<std::string> const& path) const;
+
+        /// see InitSection::getPathToEntry
+        [[nodiscard]] std::optional<std::vector<std::string> > getPathToEntry(std::string const& key) const;
+
+        /// number of entries in the default section
+        [[nodiscard]] std::size_t size() const;
+
+        [[nodiscard]] std::size_t sizeRecursive() const;
+    };
+} // namespace Init
+
+#endif // INITSHARED_H
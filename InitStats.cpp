@@ -0,0 +1,176 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+namespace Init::Stats {
+    double ApiStats::hitRate() const noexcept {
+        return calls == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(calls);
+    }
+
+    ApiStats const& LookupStats::operator[](Api api) const noexcept {
+        return apis[static_cast<std::size_t>(api)];
+    }
+
+    double ParseStats::bytesPerSecond() const noexcept {
+        auto const seconds = std::chrono::duration<double>(total).count();
+        return seconds == 0 ? 0.0 : static_cast<double>(bytes) / seconds;
+    }
+
+    double ParseStats::linesPerSecond() const noexcept {
+        auto const seconds = std::chrono::duration<double>(total).count();
+        return seconds == 0 ? 0.0 : static_cast<double>(lines) / seconds;
+    }
+
+#ifdef INIT_PARSER_STATS
+    namespace {
+        struct Counters {
+            std::atomic<std::uint64_t>                              calls{};
+            std::atomic<std::uint64_t>                              hits{};
+            std::atomic<std::uint64_t>                              misses{};
+            std::array<std::atomic<std::uint64_t>, LATENCY_BUCKETS> latency{};
+        };
+
+        std::array<Counters, API_COUNT> counters{};
+        TraceHook                       traceHook{};
+
+        // trivially constructible so that an operator new calling countAllocation() can use them at
+        // any point in a thread's life
+        thread_local std::uint64_t allocations{};
+        thread_local ParseStats    current{};
+        thread_local ParseStats    last{};
+
+        std::size_t latency_bucket(std::chrono::nanoseconds duration) {
+            auto const ns = static_cast<std::uint64_t>(std::max<std::int64_t>(duration.count(), 1));
+            return std::min<std::size_t>(std::bit_width(ns) - 1, LATENCY_BUCKETS - 1);
+        }
+
+        std::chrono::nanoseconds since(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        }
+    } // namespace
+
+    void setTraceHook(TraceHook hook) {
+        traceHook = std::move(hook);
+    }
+
+    LookupStats lookups() noexcept {
+        LookupStats result{};
+        for (std::size_t i = 0; i < API_COUNT; i++) {
+            auto& api  = result.apis[i];
+            api.calls  = counters[i].calls.load(std::memory_order_relaxed);
+            api.hits   = counters[i].hits.load(std::memory_order_relaxed);
+            api.misses = counters[i].misses.load(std::memory_order_relaxed);
+            for (std::size_t b = 0; b < LATENCY_BUCKETS; b++) {
+                api.latency[b] = counters[i].latency[b].load(std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+
+    ParseStats const& lastParse() noexcept {
+        return last;
+    }
+
+    void reset() noexcept {
+        for (auto& c: counters) {
+            c.calls.store(0, std::memory_order_relaxed);
+            c.hits.store(0, std::memory_order_relaxed);
+            c.misses.store(0, std::memory_order_relaxed);
+            for (auto& b: c.latency) {
+                b.store(0, std::memory_order_relaxed);
+            }
+        }
+        last = {};
+    }
+
+    void countAllocation() noexcept {
+        allocations++;
+    }
+
+    LookupTimer::LookupTimer(Api api) noexcept : api(api), start(std::chrono::steady_clock::now()) {}
+
+    LookupTimer::~LookupTimer() {
+        auto const duration = since(start);
+        auto&      c        = counters[static_cast<std::size_t>(api)];
+        c.calls.fetch_add(1, std::memory_order_relaxed);
+        (found ? c.hits : c.misses).fetch_add(1, std::memory_order_relaxed);
+        c.latency[latency_bucket(duration)].fetch_add(1, std::memory_order_relaxed);
+        if (traceHook) {
+            traceHook({TraceEvent::Kind::LOOKUP, api, found, duration, nullptr});
+        }
+    }
+
+    void LookupTimer::hit() noexcept {
+        found = true;
+    }
+
+    PhaseTimer::PhaseTimer(Phase phase) noexcept : phase(phase), start(std::chrono::steady_clock::now()) {}
+
+    PhaseTimer::~PhaseTimer() {
+        auto const duration = since(start);
+        switch (phase) {
+            case Phase::READ:
+                current.read += duration;
+                break;
+            case Phase::TOKENIZE:
+                current.tokenize += duration;
+                break;
+            case Phase::BUILD:
+                current.build += duration;
+                break;
+        }
+    }
+
+    ParseRecorder::ParseRecorder() noexcept : start(std::chrono::steady_clock::now()),
+                                              allocationsAtStart(allocations) {
+        current = {};
+    }
+
+    void ParseRecorder::line(std::size_t bytes) noexcept {
+        current.lines++;
+        current.bytes += bytes;
+    }
+
+    void ParseRecorder::entry() noexcept {
+        current.entries++;
+    }
+
+    void ParseRecorder::section(int depth) noexcept {
+        current.sections++;
+        current.depth[std::min<std::size_t>(static_cast<std::size_t>(depth), DEPTH_BUCKETS - 1)]++;
+    }
+
+    void ParseRecorder::finish(bool succeeded) {
+        current.total       = since(start);
+        current.allocations = allocations - allocationsAtStart;
+        // the tokenize timer runs around the whole of each line, including building the tree
+        current.tokenize -= std::min(current.tokenize, current.build);
+        last = current;
+        if (traceHook) {
+            traceHook({TraceEvent::Kind::PARSE, Api::NONE, succeeded, last.total, &last});
+        }
+    }
+#else
+    void setTraceHook(TraceHook) {}
+
+    LookupStats lookups() noexcept {
+        return {};
+    }
+
+    ParseStats const& lastParse() noexcept {
+        static ParseStats const none{};
+        return none;
+    }
+
+    void reset() noexcept {}
+
+    void countAllocation() noexcept {}
+#endif
+} // namespace Init::Stats
+
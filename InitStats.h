@@ -0,0 +1,188 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITSTATS_H
+#define INITSTATS_H
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace Init {
+    /// Optional instrumentation of parsing and lookups, compiled in when INIT_PARSER_STATS is defined
+    /// (the INIT_PARSER_STATS CMake option). Without it every recorder below is an empty inline
+    /// class, the queries return zeros and the library does no extra work at all
+    namespace Stats {
+#ifdef INIT_PARSER_STATS
+        inline constexpr bool ENABLED = true;
+#else
+        inline constexpr bool ENABLED = false;
+#endif
+
+        /// latency bucket i counts calls that took [2^i, 2^(i+1)) nanoseconds; the last bucket takes the rest
+        inline constexpr std::size_t LATENCY_BUCKETS = 32;
+
+        /// depth bucket i counts sections opened at depth i; the last bucket takes the rest
+        inline constexpr std::size_t DEPTH_BUCKETS = 16;
+
+        /// NONE is the api of a PARSE trace event; it has no lookup counters
+        enum class Api { GET_ENTRY_EXACT, CAN_RESOLVE, GET_PATH_TO_ENTRY, NONE };
+
+        inline constexpr std::size_t API_COUNT = 3;
+
+        enum class Phase { READ, TOKENIZE, BUILD };
+
+        struct ApiStats {
+            std::uint64_t                              calls{};
+            std::uint64_t                              hits{};
+            std::uint64_t                              misses{};
+            std::array<std::uint64_t, LATENCY_BUCKETS> latency{};
+
+            [[nodiscard]] double hitRate() const noexcept;
+        };
+
+        struct LookupStats {
+            std::array<ApiStats, API_COUNT> apis{};
+
+            [[nodiscard]] ApiStats const& operator[](Api api) const noexcept;
+        };
+
+        struct ParseStats {
+            std::uint64_t                            bytes{};
+            std::uint64_t                            lines{};
+            std::uint64_t                            entries{};
+            std::uint64_t                            sections{};
+            /// calls to countAllocation() on the parsing thread during the parse, so 0 unless the
+            /// application's operator new calls it
+            std::uint64_t                            allocations{};
+            std::chrono::nanoseconds                 read{};
+            /// time spent scanning lines, not counting `build`
+            std::chrono::nanoseconds                 tokenize{};
+            /// time spent adding sections and entries to the tree
+            std::chrono::nanoseconds                 build{};
+            std::chrono::nanoseconds                 total{};
+            std::array<std::uint64_t, DEPTH_BUCKETS> depth{};
+
+            [[nodiscard]] double bytesPerSecond() const noexcept;
+
+            [[nodiscard]] double linesPerSecond() const noexcept;
+        };
+
+        struct TraceEvent {
+            enum class Kind { PARSE, LOOKUP };
+
+            Kind                     kind;
+            /// the api of a LOOKUP, NONE for a PARSE
+            Api                      api;
+            /// whether a LOOKUP found what it was looking for, or a PARSE succeeded
+            bool                     hit;
+            std::chrono::nanoseconds duration;
+            /// the statistics of a PARSE, null for a LOOKUP
+            ParseStats const        *parse;
+        };
+
+        /// called synchronously, on the thread that did the work, after every parse and lookup
+        using TraceHook = std::function<void(TraceEvent const& event)>;
+
+        /// installs `hook`, or removes the current hook if `hook` is empty. Must not be called while
+        /// other threads parse or look things up
+        void setTraceHook(TraceHook hook);
+
+        /// a snapshot of the lookup counters of every thread since the last reset
+        [[nodiscard]] LookupStats lookups() noexcept;
+
+        /// the statistics of the most recent parse on this thread
+        [[nodiscard]] ParseStats const& lastParse() noexcept;
+
+        void reset() noexcept;
+
+        /// counts one allocation towards the parse in progress on this thread. The library leaves the
+        /// global allocation functions alone; call this from the application's own operator new to
+        /// have parses report their allocations
+        void countAllocation() noexcept;
+
+#ifdef INIT_PARSER_STATS
+        /// times one lookup and records it when destroyed, as a miss unless `hit()` was called first,
+        /// so lookups that throw are counted too
+        class LookupTimer {
+            Api                                   api;
+            bool                                  found{};
+            std::chrono::steady_clock::time_point start;
+
+        public:
+            explicit LookupTimer(Api api) noexcept;
+
+            LookupTimer(LookupTimer const&) = delete;
+
+            LookupTimer& operator=(LookupTimer const&) = delete;
+
+            ~LookupTimer();
+
+            void hit() noexcept;
+        };
+
+        /// adds the time until it is destroyed to `phase` of the parse in progress on this thread
+        class PhaseTimer {
+            Phase                                 phase;
+            std::chrono::steady_clock::time_point start;
+
+        public:
+            explicit PhaseTimer(Phase phase) noexcept;
+
+            PhaseTimer(PhaseTimer const&) = delete;
+
+            PhaseTimer& operator=(PhaseTimer const&) = delete;
+
+            ~PhaseTimer();
+        };
+
+        /// collects the statistics of one parse and publishes them as `lastParse()` when finished
+        class ParseRecorder {
+            std::chrono::steady_clock::time_point start;
+            std::uint64_t                         allocationsAtStart;
+
+        public:
+            ParseRecorder() noexcept;
+
+            ParseRecorder(ParseRecorder const&) = delete;
+
+            ParseRecorder& operator=(ParseRecorder const&) = delete;
+
+            void line(std::size_t bytes) noexcept;
+
+            static void entry() noexcept;
+
+            static void section(int depth) noexcept;
+
+            void finish(bool succeeded);
+        };
+#else
+        class LookupTimer {
+        public:
+            explicit LookupTimer(Api) noexcept {}
+
+            void hit() noexcept {}
+        };
+
+        class PhaseTimer {
+        public:
+            explicit PhaseTimer(Phase) noexcept {}
+        };
+
+        class ParseRecorder {
+        public:
+            void line(std::size_t) noexcept {}
+
+            static void entry() noexcept {}
+
+            static void section(int) noexcept {}
+
+            void finish(bool) noexcept {}
+        };
+#endif
+    } // namespace Stats
+} // namespace Init
+
+#endif // INITSTATS_H
@@ -0,0 +1,117 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitSubscriptions.h"
+
+#include <algorithm>
+#include <map>
+
+namespace Init {
+    InitSubscriptions::Id InitSubscriptions::add(std::vector<std::string> path, bool subtree, Callback callback) {
+        Node *node = &root;
+        for (auto const& component: path) {
+            auto& child = node->children[component];
+            if (!child) {
+                child = std::make_unique<Node>();
+            }
+            node = child.get();
+        }
+        auto const id = nextId++;
+        (subtree ? node->subtree : node->exact).push_back({
+            id,
+            std::make_shared<Callback const>(std::move(callback))
+        });
+        registered.emplace(id, std::make_pair(std::move(path), subtree));
+        return id;
+    }
+
+    bool InitSubscriptions::remove(Id id) {
+        auto const it = registered.find(id);
+        if (it == registered.end()) {
+            return false;
+        }
+        auto const& [path, subtree] = it->second;
+
+        // remember the route so that nodes left empty can be pruned on the way back up
+        std::vector<std::pair<Node *, std::string const *> > route{};
+        Node                                                *node = &root;
+        for (auto const& component: path) {
+            route.emplace_back(node, &component);
+            node = node->children.at(component).get();
+        }
+        std::erase_if(subtree ? node->subtree : node->exact, [id](Subscription const& s) { return s.id == id; });
+
+        for (auto step = route.rbegin(); step != route.rend(); ++step) {
+            auto& [parent, name] = *step;
+            auto const& child    = parent->children.at(*name);
+            if (!child->children.empty() || !child->exact.empty() || !child->subtree.empty()) {
+                break;
+            }
+            parent->children.erase(*name);
+        }
+
+        registered.erase(it);
+        return true;
+    }
+
+    bool InitSubscriptions::empty() const noexcept {
+        return registered.empty();
+    }
+
+    void InitSubscriptions::publish(InitChange change) {
+        if (batchDepth > 0) {
+            queued.push_back(std::move(change));
+            return;
+        }
+        deliver({&change, 1});
+    }
+
+    void InitSubscriptions::beginBatch() noexcept {
+        batchDepth++;
+    }
+
+    void InitSubscriptions::endBatch() {
+        if (--batchDepth > 0) {
+            return;
+        }
+        auto changes = std::move(queued);
+        queued.clear();
+        deliver(changes);
+    }
+
+    void InitSubscriptions::abandonBatch() noexcept {
+        if (--batchDepth == 0) {
+            queued.clear();
+        }
+    }
+
+    void InitSubscriptions::deliver(std::span<InitChange const> changes) const {
+        // ordered by id so subscribers are always called in the order they subscribed. The callbacks
+        // are held by shared_ptr so that a callback may subscribe or unsubscribe while being called
+        std::map<Id, std::pair<std::shared_ptr<Callback const>, std::vector<std::size_t> > > affected{};
+        for (std::size_t i = 0; i < changes.size(); i++) {
+            collect(changes[i], [&affected, i](Subscription const& s) {
+                auto& [callback, indices] = affected[s.id];
+                callback                  = s.callback;
+                if (indices.empty() || indices.back() != i) {
+                    indices.push_back(i);
+                }
+            });
+        }
+
+        for (auto const& [id, target]: affected) {
+            auto const& [callback, indices] = target;
+            if (indices.size() == changes.size()) {
+                (*callback)(changes);
+                continue;
+            }
+            std::vector<InitChange> relevant{};
+            relevant.reserve(indices.size());
+            for (auto const i: indices) {
+                relevant.push_back(changes[i]);
+            }
+            (*callback)(relevant);
+        }
+    }
+} // namespace Init
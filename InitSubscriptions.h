@@ -0,0 +1,121 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITSUBSCRIPTIONS_H
+#define INITSUBSCRIPTIONS_H
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Init {
+    /// describes one change made to a section tree. `path` is relative to the root section and
+    /// names either an entry or, if `section` is set, a section whose contents changed as a whole
+    struct InitChange {
+        enum class Type { ADDED, UPDATED, REMOVED };
+
+        Type                     type;
+        bool                     section;
+        std::vector<std::string> path;
+    };
+
+    /// The subscriptions of one section tree, indexed by path so that publishing a change only
+    /// looks at the subscriptions along that path. Owned by the root section and created when the
+    /// first subscription is made; see `InitSection::subscribe`
+    class InitSubscriptions {
+    public:
+        using Id = std::size_t;
+
+        /// receives every change relevant to the subscription: a single one for a plain mutation or all
+        /// of them at once for a transaction commit or reload
+        using Callback = std::function<void(std::span<InitChange const> changes)>;
+
+    private:
+        struct Subscription {
+            Id                              id;
+            std::shared_ptr<Callback const> callback;
+        };
+
+        struct Node {
+            std::unordered_map<std::string, std::unique_ptr<Node> > children;
+            // notified for changes at exactly this path
+            std::vector<Subscription> exact;
+            // notified for changes at this path or anywhere beneath it
+            std::vector<Subscription> subtree;
+        };
+
+        Node                                                                   root;
+        Id                                                                     nextId{1};
+        std::unordered_map<Id, std::pair<std::vector<std::string>, bool> > registered;
+        int                                                                    batchDepth{};
+        std::vector<InitChange>                                                queued;
+
+        template <class Visitor>
+        static void visitAll(Node const& node, Visitor& visit) {
+            for (auto const& s: node.exact) {
+                visit(s);
+            }
+            for (auto const& s: node.subtree) {
+                visit(s);
+            }
+            for (auto const& [name, child]: node.children) {
+                visitAll(*child, visit);
+            }
+        }
+
+        template <class Visitor>
+        void collect(InitChange const& change, Visitor visit) const {
+            Node const *node = &root;
+            for (std::size_t depth = 0;; depth++) {
+                for (auto const& s: node->subtree) {
+                    visit(s);
+                }
+                if (depth == change.path.size()) {
+                    for (auto const& s: node->exact) {
+                        visit(s);
+                    }
+                    if (change.section) {
+                        // everything registered beneath a changed section is affected
+                        for (auto const& [name, child]: node->children) {
+                            visitAll(*child, visit);
+                        }
+                    }
+                    return;
+                }
+                auto const found = node->children.find(change.path[depth]);
+                if (found == node->children.end()) {
+                    return;
+                }
+                node = found->second.get();
+            }
+        }
+
+        void deliver(std::span<InitChange const> changes) const;
+
+    public:
+        Id add(std::vector<std::string> path, bool subtree, Callback callback);
+
+        bool remove(Id id);
+
+        [[nodiscard]] bool empty() const noexcept;
+
+        void publish(InitChange change);
+
+        /// holds back published changes until the matching endBatch()
+        void beginBatch() noexcept;
+
+        /// delivers the changes held back since the outermost beginBatch(), calling each affected
+        /// subscription once
+        void endBatch();
+
+        /// drops the changes held back since the outermost beginBatch() without delivering them
+        void abandonBatch() noexcept;
+    };
+} // namespace Init
+
+#endif // INITSUBSCRIPTIONS_H
@@ -0,0 +1,311 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include "InitTransaction.h"
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "InitException.h"
+
+namespace Init {
+    namespace Util {
+        static std::string join_path(std::vector<std::string> const& path) {
+            std::string result{};
+            for (auto const& component: path) {
+                if (!result.empty()) {
+                    result.push_back('/');
+                }
+                result += component;
+            }
+            return result;
+        }
+
+        static bool same_section(std::vector<std::string> const& a, std::vector<std::string> const& b) {
+            return std::ranges::equal(a | std::views::take(a.size() - 1), b | std::views::take(b.size() - 1));
+        }
+    } // namespace Util
+
+    InitTransaction::InitTransaction(InitSection& root) : root(&root) {}
+
+    void InitTransaction::add(Kind kind, std::vector<std::string> path, std::string value) {
+        if (path.empty()) {
+            throw std::invalid_argument("InitTransaction: empty path");
+        }
+        operations.push_back({kind, std::move(path), std::move(value)});
+    }
+
+    InitTransaction& InitTransaction::set(std::string const& path, std::string value) {
+        return set(InitSection::path_to_components(path), std::move(value));
+    }
+
+    InitTransaction& InitTransaction::set(std::vector<std::string> path, std::string value) {
+        add(Kind::SET, std::move(path), std::move(value));
+        return *this;
+    }
+
+    InitTransaction& InitTransaction::create(std::string const& path, std::string value) {
+        return create(InitSection::path_to_components(path), std::move(value));
+    }
+
+    InitTransaction& InitTransaction::create(std::vector<std::string> path, std::string value) {
+        add(Kind::CREATE, std::move(path), std::move(value));
+        return *this;
+    }
+
+    InitTransaction& InitTransaction::remove(std::string const& path) {
+        return remove(InitSection::path_to_components(path));
+    }
+
+    InitTransaction& InitTransaction::remove(std::vector<std::string> path) {
+        add(Kind::REMOVE, std::move(path), {});
+        return *this;
+    }
+
+    std::size_t InitTransaction::size() const noexcept {
+        return operations.size();
+    }
+
+    bool InitTransaction::empty() const noexcept {
+        return operations.empty();
+    }
+
+    void InitTransaction::rollback() noexcept {
+        operations.clear();
+    }
+
+    void InitTransaction::commit() {
+        enum class Action { SET, CREATE, REMOVE_ENTRY, REMOVE_SECTION };
+
+        struct Step {
+            Action           action;
+            InitSection     *section;
+            Operation const *operation;
+        };
+
+        // group the operations by the section they target; the sort is stable so operations
+        // on the same section keep the order they were added in
+        std::vector<std::size_t> order(operations.size());
+        std::iota(order.begin(), order.end(), 0uz);
+        std::ranges::stable_sort(order, [this](std::size_t a, std::size_t b) {
+            auto const& p = operations[a].path;
+            auto const& q = operations[b].path;
+            return std::ranges::lexicographical_compare(
+                p | std::views::take(p.size() - 1),
+                q | std::views::take(q.size() - 1)
+            );
+        });
+
+        // resolve and check everything before changing anything
+        std::vector<Step> steps{};
+        steps.reserve(operations.size());
+        for (std::size_t first = 0; first < order.size();) {
+            auto const& path = operations[order[first]].path;
+
+            auto *section = root;
+            for (std::size_t i = 0; i + 1 < path.size() && section != nullptr; i++) {
+                section = section->findSubsection(path[i]);
+            }
+            if (section == nullptr) {
+                throw MissingEntry("InitTransaction::commit: no such section for '" + Util::join_path(path) + "'");
+            }
+
+            // whether each key touched so far in this section exists at this point of the batch
+            std::unordered_map<std::string, bool> exists{};
+            std::unordered_set<std::string>       removedSections{};
+
+            auto const present = [&](std::string const& key) {
+                auto const it = exists.find(key);
+                return it == exists.end() ? section->findEntry(key) != nullptr : it->second;
+            };
+
+            auto last = first;
+            for (; last < order.size() && Util::same_section(operations[order[last]].path, path); last++) {
+                auto const& operation = operations[order[last]];
+                auto const& key       = operation.path.back();
+                switch (operation.kind) {
+                    case Kind::SET:
+                        if (!present(key)) {
+                            throw MissingEntry(
+                                "InitTransaction::commit: no such entry '" + Util::join_path(operation.path) + "'"
+                            );
+                        }
+                        steps.push_back({Action::SET, section, &operation});
+                        break;
+                    case Kind::CREATE:
+                        exists[key] = true;
+                        steps.push_back({Action::CREATE, section, &operation});
+                        break;
+                    case Kind::REMOVE:
+                        if (present(key)) {
+                            exists[key] = false;
+                            steps.push_back({Action::REMOVE_ENTRY, section, &operation});
+                        } else if (section->findSubsection(key) != nullptr && removedSections.insert(key).second) {
+                            steps.push_back({Action::REMOVE_SECTION, section, &operation});
+                        } else {
+                            throw MissingEntry(
+                                "InitTransaction::commit: nothing to remove at '" + Util::join_path(operation.path)
+                                + "'"
+                            );
+                        }
+                        break;
+                }
+            }
+            first = last;
+        }
+
+        // subsections go last so that nothing else in the batch refers to a removed section
+        std::ranges::stable_partition(steps, [](Step const& s) { return s.action != Action::REMOVE_SECTION; });
+
+        using Totals      = InitSection::Totals;
+        using EntryNode   = decltype(InitSection::entries)::node_type;
+        using SectionNode = decltype(InitSection::subsections)::node_type;
+
+        // what it takes to put back one applied step. Removed entries and subsections are held on
+        // to rather than destroyed, so undoing a removal puts back the very same node
+        struct Undo {
+            InitSection            *section;
+            InitEntry              *changed{};
+            std::string             value{};
+            std::optional<InitName> created{};
+            EntryNode               removedEntry{};
+            SectionNode             removedSection{};
+        };
+
+        struct Change {
+            Totals added{};
+            Totals removed{};
+        };
+
+        auto const accumulate = [](Totals& t, Totals const& d) {
+            t.entries += d.entries;
+            t.sections += d.sections;
+            t.keyBytes += d.keyBytes;
+            t.valueBytes += d.valueBytes;
+            t.nameBytes += d.nameBytes;
+        };
+
+        std::vector<Undo> undo{};
+        undo.reserve(steps.size());
+        std::unordered_map<InitSection *, Change> changes{};
+        std::unordered_set<InitSection const *>   gone{};
+
+        auto *const r = root->root();
+
+        // subscribers hear about the whole commit at once, or about nothing if it is undone
+        auto *const subscriptions = r->m_subscriptions.get();
+        if (subscriptions != nullptr) {
+            subscriptions->beginBatch();
+        }
+        try {
+            // only the maps and values change here; every step records its undo before it notifies,
+            // which is the only part of a step that can throw after the tree has changed
+            for (auto const& [action, section, operation]: steps) {
+                auto const& key    = operation->path.back();
+                auto&       change = changes[section];
+                auto *const entry  = section->findEntry(key);
+                if (action == Action::SET || (action == Action::CREATE && entry != nullptr)) {
+                    auto value = operation->value;
+                    accumulate(change.added, {0, 0, 0, value.size()});
+                    accumulate(change.removed, {0, 0, 0, entry->m_value.size()});
+                    std::swap(entry->m_value, value);
+                    entry->invalidate();
+                    undo.push_back({section, entry, std::move(value)});
+                    section->notify(r, InitChange::Type::UPDATED, &entry->key());
+                } else if (action == Action::CREATE) {
+                    auto  name     = section->intern(key);
+                    auto& added    = section->entries.try_emplace(name, name, operation->value).first->second;
+                    added.m_parent = section;
+                    accumulate(change.added, {1, 0, key.size(), operation->value.size()});
+                    undo.push_back({section, nullptr, {}, std::move(name)});
+                    section->notify(r, InitChange::Type::ADDED, &added.key());
+                } else if (action == Action::REMOVE_ENTRY) {
+                    accumulate(change.removed, {1, 0, key.size(), entry->m_value.size()});
+                    undo.push_back({section, nullptr, {}, {}, section->entries.extract(section->entries.find(key))});
+                    section->notify(r, InitChange::Type::REMOVED, &key);
+                } else {
+                    auto node = section->subsections.extract(section->subsections.find(key));
+                    accumulate(change.removed, node.mapped().asChild());
+                    auto const& removed = node.mapped();
+                    undo.push_back({section, nullptr, {}, {}, {}, std::move(node)});
+                    removed.notify(r, InitChange::Type::REMOVED, nullptr);
+                }
+            }
+            for (auto const& u: undo) {
+                if (!u.removedSection.empty()) {
+                    gone.insert(&u.removedSection.mapped());
+                }
+            }
+        } catch (...) {
+            for (auto& u: undo | std::views::reverse) {
+                if (u.changed != nullptr) {
+                    std::swap(u.changed->m_value, u.value);
+                    u.changed->invalidate();
+                } else if (!u.removedEntry.empty()) {
+                    u.section->entries.insert(std::move(u.removedEntry));
+                } else if (!u.removedSection.empty()) {
+                    u.section->subsections.insert(std::move(u.removedSection));
+                } else {
+                    u.section->entries.erase(*u.created);
+                }
+            }
+            if (subscriptions != nullptr) {
+                subscriptions->abandonBatch();
+            }
+            throw;
+        }
+
+        // changes made inside a removed subsection never reach the live tree, which loses the
+        // subsection as it was before the commit
+        auto const live = [&gone](InitSection const *section) {
+            for (; section != nullptr; section = section->m_parent) {
+                if (gone.contains(section)) {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // the key index is brought up to date once for the whole batch; it is only a cache, so
+        // if that fails it is dropped and rebuilt on next use
+        if (r->m_keyIndex) {
+            try {
+                for (auto const& u: undo) {
+                    if (!u.removedEntry.empty()) {
+                        auto& removed = u.removedEntry;
+                        r->m_keyIndex->erase({removed.key(), const_cast<InitEntry *>(&removed.mapped())});
+                    } else if (!u.removedSection.empty()) {
+                        u.removedSection.mapped().unindexFrom(*r->m_keyIndex);
+                    }
+                }
+                for (auto const& u: undo) {
+                    if (u.created.has_value() && live(u.section)) {
+                        if (auto const it = u.section->entries.find(*u.created); it != u.section->entries.end()) {
+                            r->m_keyIndex->emplace(it->first, &it->second);
+                        }
+                    }
+                }
+            } catch (...) {
+                r->m_keyIndex.reset();
+            }
+        }
+
+        // and each section that changed is touched once, which carries its totals up to the root
+        for (auto const& [section, change]: changes) {
+            if (live(section)) {
+                section->touch(change.added, change.removed);
+            }
+        }
+
+        operations.clear();
+        if (subscriptions != nullptr) {
+            subscriptions->endBatch();
+        }
+    }
+} // namespace Init
@@ -0,0 +1,69 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#ifndef INITTRANSACTION_H
+#define INITTRANSACTION_H
+#include <string>
+#include <vector>
+
+#include "InitSection.h"
+
+namespace Init {
+    /// Collects a batch of changes to a section tree and applies them together.
+    ///
+    /// Paths use the syntax of `InitSection::updateEntryExact`: section names from the section the
+    /// transaction was created on, followed by the key of an entry. Nothing is changed until
+    /// `commit()`, which resolves each distinct section once, checks every operation and only then
+    /// applies the batch. If any path fails to resolve the tree is left untouched.
+    class InitTransaction {
+        enum class Kind { SET, CREATE, REMOVE };
+
+        struct Operation {
+            Kind                     kind;
+            std::vector<std::string> path;
+            std::string              value;
+        };
+
+        InitSection           *root;
+        std::vector<Operation> operations;
+
+        void add(Kind kind, std::vector<std::string> path, std::string value);
+
+    public:
+        explicit InitTransaction(InitSection& root);
+
+        /// changes the value of an existing entry
+        InitTransaction& set(std::string const& path, std::string value);
+
+        InitTransaction& set(std::vector<std::string> path, std::string value);
+
+        /// creates an entry in an existing section, replacing an entry with the same key
+        InitTransaction& create(std::string const& path, std::string value);
+
+        InitTransaction& create(std::vector<std::string> path, std::string value);
+
+        /// removes an entry or, if there is no entry with that name, a subsection.
+        /// Subsections are removed after all other operations in the batch
+        InitTransaction& remove(std::string const& path);
+
+        InitTransaction& remove(std::vector<std::string> path);
+
+        /// number of operations waiting to be committed
+        [[nodiscard]] std::size_t size() const noexcept;
+
+        [[nodiscard]] bool empty() const noexcept;
+
+        /// applies every pending operation. Throws MissingEntry without changing anything if a
+        /// section, or the entry targeted by a set or remove, does not exist. Operations on the same
+        /// entry are applied in the order they were added. Each changed section is touched and the
+        /// key index updated once for the whole batch. If applying the batch throws, every change it
+        /// made, removed subsections included, is undone first. The transaction is empty afterwards
+        void commit();
+
+        /// discards every pending operation
+        void rollback() noexcept;
+    };
+} // namespace Init
+
+#endif // INITTRANSACTION_H
@@ -24,3 +24,10 @@ std::ostream& operator<<(
     }
     return os;
 }
+
+std::ostream& operator<<(
+    std::ostream&                os,
+    Init::ParseDiagnostic const& diagnostic
+) {
+    return os << diagnostic.line << ":" << diagnostic.column << ": " << diagnostic.message;
+}
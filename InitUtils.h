@@ -6,6 +6,7 @@
 #define INITUTILS_H
 #include <ostream>
 
+#include "InitFile.h"
 #include "InitSection.h"
 
 std::ostream& operator<<(
@@ -13,4 +14,10 @@ std::ostream& operator<<(
     Init::InitSection::ResolutionType const& name
 );
 
+/// writes `line:column: message`, the form most editors and CI systems can link to
+std::ostream& operator<<(
+    std::ostream&                os,
+    Init::ParseDiagnostic const& diagnostic
+);
+
 #endif //INITUTILS_H
@@ -1,100 +1,400 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <span>
 #include <sstream>
-#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "InitException.h"
 #include "InitFile.h"
+#include "InitSerialize.h"
+#include "InitStats.h"
 #include "InitUtils.h"
-#include "InitEntry.h"
-#include "InitSection.h"
 
+namespace {
+    constexpr char const *USAGE = R"(usage: initparserxx <file> [query...]
+       initparserxx bench <file> [iterations]
+       initparserxx stats <file>
 
-template <typename T>
-std::ostream& operator<<(std::ostream& os, std::vector<T> const& v) {
-    os << "[";
-    for (int i = 0; i < v.size(); i++) {
-        os << v[i];
-        if (i != v.size() - 1) {
-            os << ", ";
+<file> is an init file or a binary snapshot written by InitBinary. It is loaded once and the
+queries are answered in order, one line of output each. With no queries on the command line,
+one query per line is read from stdin; there a path may not contain spaces if a value follows it.
+
+queries:
+  get <path>            the value of the entry at <path>
+  resolve <path>        whether <path> names an ENTRY, a SECTION or NONE
+  path <key>            the path of an entry named <key>, empty for the default section
+  set <path> <value>    changes the value of the existing entry at <path>
+  print                 the whole file, including any changes made so far
+
+bench times loading the file and looking up a sample of its entries, taking the best of
+[iterations] runs (default 10). stats reports the size of the file, and with INIT_PARSER_STATS the parse
+phases and the latencies of looking up the same sample.
+)";
+
+    using Clock = std::chrono::steady_clock;
+
+    /// how many entries `bench` and `stats` look up at most
+    constexpr std::size_t SAMPLE_SIZE = 2000;
+
+    struct Verb {
+        char const *name;
+        std::size_t arguments;
+    };
+
+    constexpr Verb VERBS[] = {{"get", 1}, {"resolve", 1}, {"path", 1}, {"set", 2}, {"print", 0}};
+
+    Verb const *find_verb(std::string_view name) {
+        auto const found = std::ranges::find_if(VERBS, [name](Verb const& v) { return name == v.name; });
+        return found == std::end(VERBS) ? nullptr : found;
+    }
+
+    double nanoseconds(Clock::duration d) {
+        return std::chrono::duration<double, std::nano>(d).count();
+    }
+
+    double milliseconds(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    /// joins `path` with slashes, escaping the slashes and backslashes inside its components
+    std::string join_path(std::vector<std::string> const& path) {
+        std::string result{};
+        for (auto const& component: path) {
+            if (!result.empty()) {
+                result.push_back('/');
+            }
+            for (char const c: component) {
+                if (c == '/' || c == '\\') {
+                    result.push_back('\\');
+                }
+                result.push_back(c);
+            }
         }
+        return result;
     }
-    os << "]";
 
-    return os;
-}
+    /// an evenly spread sample of the entries beneath `section`, since lookups in a large file can take a while
+    std::vector<Init::InitEntry> sample_entries(Init::InitSection const& section) {
+        auto                         entries = section.getAllEntriesRecursive();
+        auto const                   step    = std::max<std::size_t>(1, entries.size() / SAMPLE_SIZE);
+        std::vector<Init::InitEntry> sample{};
+        for (std::size_t i = 0; i < entries.size(); i += step) {
+            sample.push_back(std::move(entries[i]));
+        }
+        return sample;
+    }
 
-template <typename T>
-std::ostream& operator<<(std::ostream& os, std::optional<T> const& opt) {
-    if (opt.has_value()) {
-        os << "std::optional(" << opt.value() << ")";
-    } else {
-        os << "std::nullopt";
+    std::size_t file_size(std::string const& fileName) {
+        std::ifstream in{fileName, std::ios::binary | std::ios::ate};
+        return in.is_open() ? static_cast<std::size_t>(in.tellg()) : 0;
     }
-    return os;
-}
 
-std::ostream& operator<<(std::ostream& os, Init::InitEntry const& entry) {
-    os << entry.key() << "=" << entry.value();
-    return os;
-}
+    /// the file at `fileName`, read as a binary snapshot if it starts like one. Throws ParseException
+    /// listing every problem if the file is not valid
+    Init::InitFile load(std::string const& fileName) {
+        std::ifstream in{fileName, std::ios::binary};
+        if (!in.is_open()) {
+            throw Init::InitException("Could not open " + fileName);
+        }
+        char magic[4]{};
+        in.read(magic, sizeof(magic));
+        if (in.gcount() == sizeof(magic) && std::string_view{magic, sizeof(magic)} == "INIB") {
+            in.seekg(0);
+            Init::InitFile file{};
+            file.sections() = Init::InitBinary::read(in);
+            return file;
+        }
+        in.close();
 
-void old_test(Init::InitFile f) {
-    auto path = f.sections().getPathToEntry("srk1");
+        auto result = Init::InitFile::tryParse(fileName);
+        if (!result.has_value()) {
+            std::ostringstream message{};
+            for (auto const& diagnostic: result.error()) {
+                message << "\n" << fileName << ":" << diagnostic;
+            }
+            throw Init::ParseException("Invalid file" + message.str());
+        }
+        return std::move(*result);
+    }
 
-    std::cout << path << std::endl;\
+    /// writes the answer to one query to `out`, or a message to `err`. Returns false if the query failed
+    bool answer(
+        Init::InitFile&              file,
+        Verb const&                  verb,
+        std::span<std::string const> arguments,
+        std::ostream&                out,
+        std::ostream&                err
+    ) {
+        std::string_view const name{verb.name};
+        try {
+            if (name == "get") {
+                out << file.getEntryExact(arguments[0]).value() << '\n';
+            } else if (name == "resolve") {
+                out << file.canResolve(arguments[0]) << '\n';
+            } else if (name == "path") {
+                auto const path = file.getPathToEntry(arguments[0]);
+                if (!path.has_value()) {
+                    err << "path " << arguments[0] << ": no such entry\n";
+                    return false;
+                }
+                out << join_path(*path) << '\n';
+            } else if (name == "set") {
+                if (!file.sections().updateEntryExact(arguments[0], arguments[1])) {
+                    err << "set " << arguments[0] << ": no such entry\n";
+                    return false;
+                }
+            } else {
+                file.print(out);
+            }
+        } catch (std::exception const& e) {
+            err << name << " " << (arguments.empty() ? "" : arguments[0]) << ": " << e.what() << '\n';
+            return false;
+        }
+        return true;
+    }
 
-    auto p = f.sections().getPathToEntry("srk1");
-    if (!p.has_value()) {
-        throw std::runtime_error("No such entry");
+    int run_arguments(Init::InitFile& file, std::span<char const *const> tokens) {
+        bool ok = true;
+        for (std::size_t i = 0; i < tokens.size();) {
+            auto const *verb = find_verb(tokens[i]);
+            if (verb == nullptr) {
+                std::cerr << "unknown query " << tokens[i] << "\n" << USAGE;
+                return 2;
+            }
+            if (i + verb->arguments >= tokens.size()) {
+                std::cerr << verb->name << " needs " << verb->arguments << " argument(s)\n";
+                return 2;
+            }
+            std::vector<std::string> const arguments(tokens.begin() + i + 1, tokens.begin() + i + 1 + verb->arguments);
+            ok = answer(file, *verb, arguments, std::cout, std::cerr) && ok;
+            i += 1 + verb->arguments;
+        }
+        std::cout.flush();
+        return ok ? 0 : 1;
     }
-    auto value = f.sections().getEntryExact(*p);
 
-    std::cout << value << std::endl;
+    int run_stdin(Init::InitFile& file) {
+        bool        ok = true;
+        std::string line{};
+        while (std::getline(std::cin, line)) {
+            std::string_view rest{line};
+            if (!rest.empty() && rest.back() == '\r') {
+                rest.remove_suffix(1);
+            }
+            auto const start = rest.find_first_not_of(" \t");
+            if (start == std::string_view::npos || rest[start] == '#') {
+                continue;
+            }
+            rest.remove_prefix(start);
+            auto const end      = std::min(rest.find_first_of(" \t"), rest.size());
+            auto const verbName = rest.substr(0, end);
+            rest.remove_prefix(end);
+            rest.remove_prefix(std::min(rest.find_first_not_of(" \t"), rest.size()));
+
+            auto const *verb = find_verb(verbName);
+            if (verb == nullptr) {
+                std::cerr << "unknown query " << verbName << '\n';
+                ok = false;
+                continue;
+            }
+            // the last argument takes the rest of the line so that it may contain spaces
+            std::vector<std::string> arguments{};
+            for (std::size_t a = 1; a < verb->arguments; a++) {
+                auto const space = std::min(rest.find_first_of(" \t"), rest.size());
+                arguments.emplace_back(rest.substr(0, space));
+                rest.remove_prefix(space);
+                rest.remove_prefix(std::min(rest.find_first_not_of(" \t"), rest.size()));
+            }
+            if (verb->arguments > 0) {
+                arguments.emplace_back(rest);
+            }
+            if (verb->arguments > 0 && arguments.front().empty()) {
+                std::cerr << verb->name << " needs " << verb->arguments << " argument(s)\n";
+                ok = false;
+                continue;
+            }
+            ok = answer(file, *verb, arguments, std::cout, std::cerr) && ok;
+            // whoever is on the other end of a pipe may be waiting for this answer
+            std::cout.flush();
+        }
+        return ok ? 0 : 1;
+    }
 
-    std::cout << f.sections().hasEntry("srk1") << std::endl;
-    std::cout << (f.sections().canResolve({"srk1"}) == Init::InitSection::ResolutionType::ENTRY) << std::endl;
+    /// times `lookup` over every path, returning the average in nanoseconds and the number that failed
+    template <typename Lookup>
+    std::pair<double, std::size_t> time_lookups(
+        std::vector<std::vector<std::string> > const& paths,
+        Lookup                                        lookup
+    ) {
+        std::size_t failed = 0;
+        auto const  start  = Clock::now();
+        for (auto const& path: paths) {
+            try {
+                if (!lookup(path)) {
+                    failed++;
+                }
+            } catch (Init::InitException const&) {
+                failed++;
+            }
+        }
+        auto const elapsed = Clock::now() - start;
+        return {paths.empty() ? 0.0 : nanoseconds(elapsed) / static_cast<double>(paths.size()), failed};
+    }
 
-    f.sections().updateEntryExact(path.value(), "anewtestingvalue");
+    int bench(std::string const& fileName, int iterations) {
+        auto                best = Clock::duration::max();
+        std::vector<double> loads{};
+        Init::InitFile      file{};
+        for (int i = 0; i < iterations; i++) {
+            auto const start   = Clock::now();
+            file               = load(fileName);
+            auto const elapsed = Clock::now() - start;
+            best               = std::min(best, elapsed);
+            loads.push_back(milliseconds(elapsed));
+        }
+        std::ranges::sort(loads);
 
-    auto e = f.sections().getEntryExact({"srk1"});
-    std::cout << e.value() << std::endl;
+        auto const bytes = file_size(fileName);
+        std::cout << "load            best " << milliseconds(best) << " ms, median " << loads[loads.size() / 2]
+                  << " ms, " << bytes << " bytes at "
+                  << static_cast<double>(bytes) / std::chrono::duration<double>(best).count() / 1e6 << " MB/s\n";
 
-    std::ofstream out{};
-    out.open("new_test.init");
-    f.print(out);
-    out.close();
+        std::vector<std::vector<std::string> > paths{};
+        std::vector<std::vector<std::string> > keys{};
+        for (auto const& entry: sample_entries(file.sections())) {
+            paths.push_back(entry.path());
+            keys.push_back({entry.key()});
+        }
 
-    std::stringstream ss;
-    f.print(ss);
-    std::cout << ss.str() << std::endl;
-}
+        auto const report = [&](char const *label, auto const& sample, auto lookup) {
+            auto best = std::pair{std::numeric_limits<double>::max(), std::size_t{}};
+            for (int i = 0; i < iterations; i++) {
+                best = std::min(best, time_lookups(sample, lookup));
+            }
+            std::cout << label << best.first << " ns per lookup over " << sample.size();
+            if (best.second != 0) {
+                std::cout << ", " << best.second << " not found";
+            }
+            std::cout << '\n';
+        };
 
-int main(int argc, char const *argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <file>" << std::endl;
-        return 1;
+        auto const& sections = file.sections();
+        report("getEntryExact   ", paths, [&](auto const& path) {
+            return !sections.getEntryExact(path).key().empty();
+        });
+        report("canResolve      ", paths, [&](auto const& path) {
+            return sections.canResolve(path) == Init::InitSection::ResolutionType::ENTRY;
+        });
+        report("getPathToEntry  ", keys, [&](auto const& key) {
+            return sections.getPathToEntry(key.front()).has_value();
+        });
+        file.enableLookupCache(paths.size() + 1);
+        report("cached lookups  ", paths, [&](auto const& path) {
+            return !file.getEntryExact(path).key().empty();
+        });
+        return 0;
     }
 
-    auto file = Init::InitFile::parse("../problem.init");
+    int stats(std::string const& fileName) {
+        Init::Stats::reset();
+        auto const start   = Clock::now();
+        auto       file    = load(fileName);
+        auto const elapsed = Clock::now() - start;
 
-    auto const& f = file.sections().getEntryExact({"Server-URL","routes","index","file"});
-    file.sections().updateEntryExact(
-        "Server-URL/routes/index/file",
-        "test.html"
-    );
-    auto o = file.sections().getPathToEntry("auth");
-    file.sections().updateEntryExact(*o, "some-other-file.html");
-    std::cout << f.value() << std::endl;
+        auto& sections = file.sections();
+        std::cout << "file            " << fileName << ", " << file_size(fileName) << " bytes loaded in "
+                  << milliseconds(elapsed) << " ms\n"
+                  << "entries         " << sections.sizeRecursive() << '\n'
+                  << "sections        " << sections.subsectionCountRecursive() << '\n'
+                  << "key bytes       " << sections.keyBytesRecursive() << '\n'
+                  << "value bytes     " << sections.valueBytesRecursive() << '\n'
+                  << "distinct names  " << sections.internedNames() << '\n'
+                  << "memory          " << sections.memoryFootprint() << " bytes\n";
 
-    auto& e = file.sections().getEntryExact({"Server-URL","hostname"});
-    e.value() = "some-other-hostname.html";
+        if constexpr (!Init::Stats::ENABLED) {
+            std::cout << "configure with -DINIT_PARSER_STATS=ON for parse phases and lookup latencies\n";
+            return 0;
+        }
 
-    std::ofstream of;
-    of.open("testout.init");
+        auto const& parse = Init::Stats::lastParse();
+        std::cout << "lines           " << parse.lines << ", " << parse.linesPerSecond() << " per second\n"
+                  << "read            " << milliseconds(parse.read) << " ms\n"
+                  << "tokenize        " << milliseconds(parse.tokenize) << " ms\n"
+                  << "build           " << milliseconds(parse.build) << " ms\n"
+                  << "allocations     " << parse.allocations << '\n'
+                  << "sections/depth ";
+        for (std::size_t depth = 0; depth < Init::Stats::DEPTH_BUCKETS; depth++) {
+            if (parse.depth[depth] != 0) {
+                std::cout << ' ' << depth << ':' << parse.depth[depth];
+            }
+        }
+        std::cout << '\n';
 
-    file.print(of);
+        // one of each lookup per sampled entry, so the latencies below describe this file
+        for (auto const& entry: sample_entries(sections)) {
+            auto const path = entry.path();
+            (void) sections.canResolve(path);
+            try {
+                (void) sections.getEntryExact(path);
+            } catch (Init::InitException const&) {}
+        }
+        auto const lookups = Init::Stats::lookups();
+        for (auto const& [api, label]: {
+                 std::pair{Init::Stats::Api::GET_ENTRY_EXACT, "getEntryExact   "},
+                 std::pair{Init::Stats::Api::CAN_RESOLVE, "canResolve      "}
+             }) {
+            auto const& s = lookups[api];
+            // the bucket holding the median call; bucket i is [2^i, 2^(i+1)) ns
+            std::uint64_t seen   = 0;
+            std::size_t   median = 0;
+            while (median + 1 < Init::Stats::LATENCY_BUCKETS && (seen += s.latency[median]) * 2 < s.calls) {
+                median++;
+            }
+            std::cout << label << s.calls << " calls, " << s.hitRate() * 100 << "% found, median under "
+                      << (std::uint64_t{2} << median) << " ns\n";
+        }
+        return 0;
+    }
+} // namespace
 
+int main(int argc, char const *argv[]) {
+    std::ios::sync_with_stdio(false);
 
-    return 0;
+    std::span<char const *const> const args{argv + 1, static_cast<std::size_t>(std::max(argc - 1, 0))};
+    if (args.empty() || std::strcmp(args[0], "-h") == 0 || std::strcmp(args[0], "--help") == 0) {
+        std::cerr << USAGE;
+        return args.empty() ? 2 : 0;
+    }
+
+    try {
+        std::string_view const command{args[0]};
+        if (command == "bench" || command == "stats") {
+            if (args.size() < 2) {
+                std::cerr << USAGE;
+                return 2;
+            }
+            if (command == "stats") {
+                return stats(args[1]);
+            }
+            auto const iterations = args.size() > 2 ? std::max(1, std::atoi(args[2])) : 10;
+            return bench(args[1], iterations);
+        }
+
+        auto file = load(args[0]);
+        file.enableLookupCache(1024);
+        if (args.size() == 1) {
+            return run_stdin(file);
+        }
+        return run_arguments(file, args.subspan(1));
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << '\n';
+        return 2;
+    }
 }
@@ -0,0 +1,30 @@
+//
+// Created by Thomas Povinelli on 10/19/26.
+//
+
+#include <cassert>
+#include <iostream>
+
+#include "../InitFile.h"
+
+// assigning a parsed file into an existing one brings the name pool of the parsed file along
+int main() {
+    auto       file     = Init::InitFile::parse("sample.init");
+    auto const distinct = Init::InitFile::parse("problem.init").sections().internedNames();
+    assert(distinct > 1);
+
+    file = Init::InitFile::parse("problem.init");
+    assert(file.sections().internedNames() == distinct);
+
+    // a name that is already present is looked up in the adopted pool rather than added again
+    file.sections().getSubsection("Server-URL").createEntry("hostname", "example.com");
+    assert(file.sections().internedNames() == distinct);
+
+    // a subsection moved in from another tree shares its names with this one
+    auto other = Init::InitFile::parse("problem.init");
+    file.sections().createSubsection("copy") = std::move(other.sections());
+    assert(file.sections().internedNames() == distinct + 1);
+
+    std::cout << "ok" << std::endl;
+    return 0;
+}